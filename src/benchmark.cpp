@@ -0,0 +1,697 @@
+// Standalone benchmark, not part of the Visual Studio demo project.
+//
+//    g++ -std=c++20 -O2 -mavx2 -pthread src/benchmark.cpp src/peasycamera.cpp src/peasycamera_instrument.cpp src/peasycamera_parallel.cpp src/peasycamera_path.cpp src/peasycamera_recorder.cpp src/peasycamera_trace.cpp -o benchmark
+//    cl /std:c++latest /O2 /arch:AVX2 src\benchmark.cpp src\peasycamera.cpp src\peasycamera_instrument.cpp src\peasycamera_parallel.cpp src\peasycamera_path.cpp src\peasycamera_recorder.cpp src\peasycamera_trace.cpp
+
+#include "peasycamera.h"
+#include "peasycamera_input_queue.h"
+#include "peasycamera_instrument.h"
+#include "peasycamera_parallel.h"
+#include "peasycamera_path.h"
+#include "peasycamera_recorder.h"
+#include "peasycamera_trace.h"
+
+#include <algorithm>
+#include <chrono>
+#include <memory>
+#include <span>
+#include <thread>
+#include <vector>
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+
+namespace {
+   using Clock = std::chrono::steady_clock;
+
+   // Small deterministic generator so every run benchmarks the same data.
+   struct Random {
+      unsigned int m_state = 0x12345678u;
+
+      float Next() {
+         m_state ^= m_state << 13;
+         m_state ^= m_state >> 17;
+         m_state ^= m_state << 5;
+         return float(m_state & 0xffffff) / float(0xffffff) * 2.0f - 1.0f;
+      }
+   };
+
+   peasycamera::CameraState RandomState(Random& random) {
+      peasycamera::quat q = {random.Next(), random.Next(), random.Next(), random.Next()};
+      const float inv = 1.0f / sqrtf(q.x * q.x + q.y * q.y + q.z * q.z + q.w * q.w);
+      q = {q.x * inv, q.y * inv, q.z * inv, q.w * inv};
+      return {q, {10.0f * random.Next(), 10.0f * random.Next(), 10.0f * random.Next()}, 5.0f + 4.0f * random.Next()};
+   }
+
+   template <typename Function>
+   double NanosecondsPerItem(size_t items, int repetitions, Function&& function) {
+      double best = 1e30;
+      for (int r = 0; r < repetitions; ++r) {
+         const Clock::time_point start = Clock::now();
+         function();
+         const double ns = std::chrono::duration<double, std::nano>(Clock::now() - start).count();
+         best = ns < best ? ns : best;
+      }
+      return best / double(items);
+   }
+
+   // The normalize + cross product look-at construction CalculateViewMatrix used before it
+   // switched to the closed-form quaternion basis. Kept here to check the new path against.
+   void ReferenceViewMatrix(const peasycamera::CameraState& state, float* out) {
+      const peasycamera::quat& q = state.m_rotation;
+      const float back[3] = {2.0f * (q.z * q.x - q.w * q.y), 2.0f * (q.w * q.x + q.z * q.y), 2.0f * (q.w * q.w + q.z * q.z) - 1.0f};
+      const float up[3] = {2.0f * (q.w * q.z + q.y * q.x), 2.0f * (q.w * q.w + q.y * q.y) - 1.0f, 2.0f * (q.y * q.z - q.w * q.x)};
+      const float position[3] = {state.m_distance * back[0] + state.m_lookAt.x, state.m_distance * back[1] + state.m_lookAt.y, state.m_distance * back[2] + state.m_lookAt.z};
+
+      float z[3] = {state.m_lookAt.x - position[0], state.m_lookAt.y - position[1], state.m_lookAt.z - position[2]};
+      const float zInv = 1.0f / sqrtf(z[0] * z[0] + z[1] * z[1] + z[2] * z[2]);
+      z[0] *= zInv; z[1] *= zInv; z[2] *= zInv;
+
+      float x[3] = {z[1] * up[2] - z[2] * up[1], z[2] * up[0] - z[0] * up[2], z[0] * up[1] - z[1] * up[0]};
+      const float xInv = 1.0f / sqrtf(x[0] * x[0] + x[1] * x[1] + x[2] * x[2]);
+      x[0] *= xInv; x[1] *= xInv; x[2] *= xInv;
+
+      const float y[3] = {x[1] * z[2] - x[2] * z[1], x[2] * z[0] - x[0] * z[2], x[0] * z[1] - x[1] * z[0]};
+
+      const float result[16] = {
+         x[0], y[0], -z[0], 0.0f,
+         x[1], y[1], -z[1], 0.0f,
+         x[2], y[2], -z[2], 0.0f,
+         -(x[0] * position[0] + x[1] * position[1] + x[2] * position[2]),
+         -(y[0] * position[0] + y[1] * position[1] + y[2] * position[2]),
+         z[0] * position[0] + z[1] * position[1] + z[2] * position[2],
+         1.0f,
+      };
+
+      for (int i = 0; i < 16; ++i) {
+         out[i] = result[i];
+      }
+   }
+
+   float g_sink = 0.0f;
+
+   // Largest difference from ReferenceViewMatrix either view matrix path may have. The matrices
+   // hold translations up to about 30, where a float step is 2e-6.
+   constexpr float kViewMatrixTolerance = 1e-4f;
+
+   bool BenchmarkViewMatrices(size_t count) {
+      Random random;
+      std::vector<peasycamera::Camera> cameras(count, peasycamera::Camera(5.0f));
+      std::vector<peasycamera::CameraState> states(count);
+      for (size_t i = 0; i < count; ++i) {
+         states[i] = RandomState(random);
+         cameras[i].m_state = states[i];
+      }
+
+      std::vector<float> matrices(16 * count);
+
+      float maxError = 0.0f;
+      peasycamera::CalculateViewMatrices(states.data(), count, matrices.data());
+      for (size_t i = 0; i < count; ++i) {
+         float reference[16];
+         ReferenceViewMatrix(states[i], reference);
+         cameras[i].CalculateViewMatrix();
+         for (int j = 0; j < 16; ++j) {
+            maxError = fmaxf(maxError, fmaxf(fabsf(matrices[16 * i + j] - reference[j]), fabsf(cameras[i].m_viewMatrix[j] - reference[j])));
+         }
+      }
+      const bool passed = maxError <= kViewMatrixTolerance;
+
+      const double reference = NanosecondsPerItem(count, 20, [&]() {
+         float matrix[16];
+         for (const peasycamera::CameraState& state : states) {
+            ReferenceViewMatrix(state, matrix);
+            g_sink += matrix[14];
+         }
+      });
+
+      const double perCamera = NanosecondsPerItem(count, 20, [&]() {
+         for (peasycamera::Camera& camera : cameras) {
+            camera.CalculateViewMatrix();
+            g_sink += camera.m_viewMatrix[14];
+         }
+      });
+
+      const double batched = NanosecondsPerItem(count, 20, [&]() {
+         peasycamera::CalculateViewMatrices(states.data(), count, matrices.data());
+         g_sink += matrices[14];
+      });
+
+      printf("view matrices, %8zu cameras: look-at reference %6.2f ns/camera, Camera::CalculateViewMatrix %6.2f ns/camera, CalculateViewMatrices %6.2f ns/camera, %.2fx, max error vs reference %g, %s\n", count, reference, perCamera, batched, perCamera / batched,
+             maxError, passed ? "ok" : "FAILED");
+      return passed;
+   }
+
+   // Every camera orbits with the left button held so no camera falls asleep.
+   std::vector<peasycamera::Input> DragInputs(size_t count, Random& random) {
+      std::vector<peasycamera::Input> inputs(count);
+      for (peasycamera::Input& input : inputs) {
+         input = { };
+         input.viewport[2] = 1280;
+         input.viewport[3] = 720;
+         input.mouseX = 640 + int(300.0f * random.Next());
+         input.mouseY = 360 + int(200.0f * random.Next());
+         input.mouseDX = int(8.0f * random.Next());
+         input.mouseDY = int(8.0f * random.Next());
+         input.leftMouseButtonDown = true;
+         input.deltaTimeInSeconds = 1.0f / 60.0f;
+      }
+      return inputs;
+   }
+
+   void BenchmarkParallelUpdate(size_t count, unsigned maxThreads) {
+      Random random;
+      const std::vector<peasycamera::Input> inputs = DragInputs(count, random);
+
+      // Powers of two, then maxThreads itself when it is not one.
+      std::vector<unsigned> threadCounts;
+      for (unsigned threads = 1; threads < maxThreads; threads *= 2) {
+         threadCounts.push_back(threads);
+      }
+      threadCounts.push_back(maxThreads);
+
+      double singleThreaded = 0.0;
+      for (unsigned threads : threadCounts) {
+         peasycamera::ThreadPool pool(threads);
+
+         peasycamera::CameraBatch batch;
+         for (size_t i = 0; i < count; ++i) {
+            batch.Add(peasycamera::Camera(5.0f));
+         }
+
+         const double ns = NanosecondsPerItem(count, 10, [&]() {
+            peasycamera::UpdateAll(pool, batch, inputs);
+            g_sink += batch.m_viewMatrix[0].m_elements[14];
+         });
+
+         singleThreaded = threads == 1 ? ns : singleThreaded;
+         printf("parallel update + view matrices, %8zu cameras, %2u threads: %6.2f ns/camera, %.2fx\n", count, threads, ns, singleThreaded / ns);
+      }
+   }
+
+   // peasycamera::UpdateAll has to give the same states and view matrices as the serial
+   // CameraBatch::UpdateAll + CalculateViewMatrices at any thread count. Small chunks make the
+   // workers steal from each other.
+   bool CheckParallelUpdate(size_t count, int frameCount, unsigned maxThreads) {
+      peasycamera::TraceSettings settings;
+      settings.m_frameTimeJitter = 0.05f;
+
+      std::vector<unsigned> threadCounts = {1, 2, 3, 8};
+      if (std::find(threadCounts.begin(), threadCounts.end(), maxThreads) == threadCounts.end()) {
+         threadCounts.push_back(maxThreads);
+      }
+
+      bool passed = true;
+      for (unsigned threads : threadCounts) {
+         peasycamera::ThreadPool pool(threads);
+
+         std::vector<peasycamera::TraceGenerator> generators;
+         generators.reserve(count);
+         peasycamera::CameraBatch serial;
+         peasycamera::CameraBatch parallel;
+         for (size_t i = 0; i < count; ++i) {
+            generators.emplace_back(settings, i);
+            peasycamera::Camera camera(10.0f);
+            camera.SetDampingMode(peasycamera::DampingMode(i % 3));
+            serial.Add(camera);
+            parallel.Add(camera);
+         }
+
+         std::vector<peasycamera::Input> inputs(count);
+         size_t mismatches = 0;
+         for (int frame = 0; frame < frameCount; ++frame) {
+            for (size_t i = 0; i < count; ++i) {
+               inputs[i] = generators[i].Next();
+            }
+            serial.UpdateAll(inputs);
+            serial.CalculateViewMatrices();
+            peasycamera::UpdateAll(pool, parallel, inputs, 256);
+
+            for (size_t i = 0; i < count; ++i) {
+               const bool same = memcmp(&serial.m_state[i], &parallel.m_state[i], sizeof(peasycamera::CameraState)) == 0 &&
+                                 memcmp(serial.m_viewMatrix[i].m_elements, parallel.m_viewMatrix[i].m_elements, sizeof(serial.m_viewMatrix[i].m_elements)) == 0;
+               mismatches += same ? 0 : 1;
+            }
+         }
+
+         printf("parallel UpdateAll vs serial, %zu cameras, %d frames, %2u threads: %zu mismatches, %s\n", count, frameCount, threads, mismatches, mismatches == 0 ? "ok" : "FAILED");
+         passed = passed && mismatches == 0;
+      }
+      return passed;
+   }
+
+   // A camera at rest after one frame of dragging with the given mouse button, with dy for the zoom.
+   peasycamera::Camera ReleasedCamera(peasycamera::DampingMode mode, int dx, int dy, bool zoom) {
+      peasycamera::Camera camera(20.0f);
+      camera.SetDampingMode(mode);
+
+      peasycamera::Input input = { };
+      input.viewport[2] = 800;
+      input.viewport[3] = 600;
+      input.mouseX = 400;
+      input.mouseY = 300;
+      input.mouseDX = dx;
+      input.mouseDY = dy;
+      input.leftMouseButtonDown = !zoom;
+      input.rightMouseButtonDown = zoom;
+      input.deltaTimeInSeconds = 1.0f / 60.0f;
+      camera.Update(input);
+      return camera;
+   }
+
+   void Release(peasycamera::Camera& camera, float deltaTimeInSeconds, int updates) {
+      peasycamera::Input input = { };
+      input.viewport[2] = 800;
+      input.viewport[3] = 600;
+      input.deltaTimeInSeconds = deltaTimeInSeconds;
+      for (int i = 0; i < updates; ++i) {
+         camera.Update(input);
+      }
+   }
+
+   // One 2 s TimeBased update has to land where 120 PerUpdate steps at 60 Hz do, for zoom
+   // impulses large enough that log(1 + 0.02 v) is far from its series, and for an orbit whose
+   // axes come to rest at different steps.
+   bool CheckTimeBasedDamping() {
+      bool passed = true;
+      const struct { int dx, dy; bool zoom; } impulses[] = {{0, 100, true}, {0, -60, true}, {0, 30, true}, {40, 25, false}, {-7, 90, false}};
+      for (const auto& impulse : impulses) {
+         peasycamera::Camera stepped = ReleasedCamera(peasycamera::DampingMode::PerUpdate, impulse.dx, impulse.dy, impulse.zoom);
+         peasycamera::Camera timeBased = ReleasedCamera(peasycamera::DampingMode::TimeBased, impulse.dx, impulse.dy, impulse.zoom);
+         Release(stepped, 1.0f / 60.0f, 120);
+         Release(timeBased, 2.0f, 1);
+
+         const peasycamera::CameraState& a = stepped.m_state;
+         const peasycamera::CameraState& b = timeBased.m_state;
+         const float distanceError = fabsf(b.m_distance / a.m_distance - 1.0f);
+         const float rotationError = fmaxf(fmaxf(fabsf(b.m_rotation.x - a.m_rotation.x), fabsf(b.m_rotation.y - a.m_rotation.y)), fmaxf(fabsf(b.m_rotation.z - a.m_rotation.z), fabsf(b.m_rotation.w - a.m_rotation.w)));
+         const bool matches = distanceError < 1e-4f && rotationError < 1e-5f;
+         printf("TimeBased 2 s vs 120 PerUpdate steps, %s %d %d: distance %g relative, rotation %g, %s\n", impulse.zoom ? "zoom" : "orbit", impulse.dx, impulse.dy, distanceError, rotationError,
+                matches ? "ok" : "FAILED");
+         passed = passed && matches;
+      }
+      return passed;
+   }
+
+   // PredictState has to land where the Updates it predicts do: PerUpdate actions at any update
+   // rate, TimeBased ones at rates that cover whole PerUpdate steps. Faster TimeBased updates let
+   // the velocity glide on below the cutoff, see RestingVelocity.
+   bool CheckPrediction() {
+      bool passed = true;
+      const struct { int dx, dy; bool zoom; } impulses[] = {{0, 100, true}, {0, -60, true}, {40, 25, false}};
+      for (peasycamera::DampingMode mode : {peasycamera::DampingMode::PerUpdate, peasycamera::DampingMode::TimeBased}) {
+         for (float rateInHz : {mode == peasycamera::DampingMode::PerUpdate ? 144.0f : 30.0f, 60.0f}) {
+            for (const auto& impulse : impulses) {
+               peasycamera::Camera camera = ReleasedCamera(mode, impulse.dx, impulse.dy, impulse.zoom);
+               Release(camera, 1.0f / rateInHz, 1);
+
+               const int updates = int(rateInHz / 2.0f);
+               const peasycamera::CameraState predicted = camera.PredictState(float(updates) / rateInHz);
+               Release(camera, 1.0f / rateInHz, updates);
+
+               const peasycamera::CameraState& a = camera.m_state;
+               const float distanceError = fabsf(predicted.m_distance / a.m_distance - 1.0f);
+               const float rotationError = fmaxf(fmaxf(fabsf(predicted.m_rotation.x - a.m_rotation.x), fabsf(predicted.m_rotation.y - a.m_rotation.y)),
+                                                 fmaxf(fabsf(predicted.m_rotation.z - a.m_rotation.z), fabsf(predicted.m_rotation.w - a.m_rotation.w)));
+               const bool matches = distanceError < 1e-4f && rotationError < 1e-5f;
+               printf("PredictState vs %d Updates at %.0f Hz, %s, %s %d %d: distance %g relative, rotation %g, %s\n", updates, rateInHz,
+                      mode == peasycamera::DampingMode::TimeBased ? "TimeBased" : "PerUpdate", impulse.zoom ? "zoom" : "orbit", impulse.dx, impulse.dy, distanceError, rotationError,
+                      matches ? "ok" : "FAILED");
+               passed = passed && matches;
+            }
+         }
+      }
+      return passed;
+   }
+
+   // CameraBatch::UpdateAll and UpdateActive have to match Camera::Update bit for bit, sleep and
+   // epoch included, for every damping mode, with settle thresholds and animated SetState calls.
+   bool CheckBatch(size_t count, int frameCount) {
+      const peasycamera::DampingMode modes[] = {peasycamera::DampingMode::PerUpdate, peasycamera::DampingMode::TimeBased, peasycamera::DampingMode::Spring};
+
+      peasycamera::TraceSettings settings;
+      std::vector<peasycamera::TraceGenerator> generators;
+      generators.reserve(count);
+      std::vector<peasycamera::Camera> cameras;
+      peasycamera::CameraBatch all;
+      peasycamera::CameraBatch active;
+      for (size_t i = 0; i < count; ++i) {
+         generators.emplace_back(settings, i);
+
+         peasycamera::Camera camera(10.0f);
+         camera.SetDampingMode(modes[i % 3]);
+         if (i % 2 == 1) {
+            camera.SetSettleThreshold(0.5f, 1.0f);
+         }
+         cameras.push_back(camera);
+         all.Add(camera);
+         active.Add(camera);
+      }
+
+      Random random;
+      std::vector<peasycamera::Input> inputs(count);
+      std::vector<peasycamera::CameraBatch::IndexedInput> indexedInputs(count);
+      size_t stateMismatches = 0;
+      size_t sleepMismatches = 0;
+      size_t epochMismatches = 0;
+      for (int frame = 0; frame < frameCount; ++frame) {
+         for (size_t i = 0; i < count; ++i) {
+            if (frame % 90 == 45 && (i + size_t(frame)) % 7 == 0) {
+               const peasycamera::CameraState state = RandomState(random);
+               cameras[i].SetState(state, 0.5f);
+               all.SetState(i, state, 0.5f);
+               active.SetState(i, state, 0.5f);
+            }
+
+            inputs[i] = generators[i].Next();
+            indexedInputs[i] = {uint32_t(i), inputs[i]};
+            cameras[i].Update(inputs[i]);
+         }
+         all.UpdateAll(inputs);
+         active.UpdateActive(indexedInputs, inputs[0].deltaTimeInSeconds);
+
+         for (size_t i = 0; i < count; ++i) {
+            for (const peasycamera::CameraBatch* batch : {&all, &active}) {
+               stateMismatches += memcmp(&batch->m_state[i], &cameras[i].m_state, sizeof(peasycamera::CameraState)) != 0 ? 1 : 0;
+               sleepMismatches += batch->IsAsleep(i) != cameras[i].IsAsleep() ? 1 : 0;
+               epochMismatches += batch->m_epoch[i] != cameras[i].GetEpoch() ? 1 : 0;
+            }
+         }
+      }
+
+      const bool passed = stateMismatches == 0 && sleepMismatches == 0 && epochMismatches == 0;
+      printf("CameraBatch UpdateAll and UpdateActive vs Camera::Update, %zu cameras, %d frames: %zu state, %zu sleep, %zu epoch mismatches, %s\n", count, frameCount, stateMismatches, sleepMismatches,
+             epochMismatches, passed ? "ok" : "FAILED");
+      return passed;
+   }
+
+   // A horizontal shift drag of 6 pixels per 60 Hz frame has to lock to yaw whatever the mouse
+   // polling rate, even though a fast mouse moves less than a pixel per event.
+   bool CheckShiftDragLock() {
+      const int viewport[4] = {0, 0, 1280, 720};
+
+      bool passed = true;
+      for (int rateInHz : {60, 1000, 8000}) {
+         const int eventsPerFrame = rateInHz / 60;
+         std::vector<peasycamera::InputEvent> events(eventsPerFrame);
+
+         peasycamera::Camera camera(5.0f);
+         float mouseX = 400.0f;
+         for (int frame = 0; frame < 10; ++frame) {
+            for (int i = 0; i < eventsPerFrame; ++i) {
+               const float dx = 6.0f / float(eventsPerFrame);
+               mouseX += dx;
+               events[i] = {float(i) / float(rateInHz), mouseX, 200.0f, dx, 0.0f, 0.0f, true, false, false, true};
+            }
+            camera.Update(events, viewport, 1.0f / 60.0f);
+         }
+
+         const bool locked = camera.m_dragConstraint == peasycamera::Constraint::Yaw && camera.m_rotateX.m_velocity == 0.0f && camera.m_rotateZ.m_velocity == 0.0f;
+         printf("shift drag at %5d Hz: rotate velocity x %g, y %g, z %g, %s\n", rateInHz, camera.m_rotateX.m_velocity, camera.m_rotateY.m_velocity, camera.m_rotateZ.m_velocity, locked ? "locked to yaw" : "FAILED");
+         passed = passed && locked;
+      }
+      return passed;
+   }
+
+   // One camera fed by a mouse polling at rateInHz, one Update per 60 Hz frame.
+   void BenchmarkInputEvents(int rateInHz, peasycamera::DampingMode mode) {
+      const int frames = 600;
+      const int eventsPerFrame = rateInHz / 60;
+      const int viewport[4] = {0, 0, 1280, 720};
+
+      Random random;
+      std::vector<peasycamera::InputEvent> events(size_t(frames) * eventsPerFrame);
+      for (size_t i = 0; i < events.size(); ++i) {
+         const float time = float(i % eventsPerFrame) / float(rateInHz);
+         events[i] = {time, 640.0f + 300.0f * random.Next(), 360.0f + 200.0f * random.Next(), random.Next(), random.Next(), 0.0f, true, false, false, false};
+      }
+
+      const double ns = NanosecondsPerItem(events.size(), 10, [&]() {
+         peasycamera::Camera camera(5.0f);
+         camera.SetDampingMode(mode);
+         for (int frame = 0; frame < frames; ++frame) {
+            camera.Update(std::span<const peasycamera::InputEvent>(events.data() + size_t(frame) * eventsPerFrame, eventsPerFrame), viewport, 1.0f / 60.0f);
+         }
+         g_sink += camera.m_state.m_rotation.x;
+      });
+
+      const char* modeName = mode == peasycamera::DampingMode::Spring ? "Spring" : (mode == peasycamera::DampingMode::TimeBased ? "TimeBased" : "PerUpdate");
+      printf("input events, %5d Hz, %s damping: %6.2f ns/event, %5.2f%% of a core\n", rateInHz, modeName, ns, ns * rateInHz * 1e-7);
+   }
+
+   using InputQueue = peasycamera::InputEventQueue<4096>;
+
+   peasycamera::InputEvent SyntheticEvent(Random& random) {
+      return {0.0f, 640.0f + 300.0f * random.Next(), 360.0f + 200.0f * random.Next(), random.Next(), random.Next(), 0.0f, true, false, false, false};
+   }
+
+   // A producer thread pushes events as fast as the queue takes them; the consumer drains
+   // them, into a camera or not at all.
+   void BenchmarkInputQueueThroughput(bool updateCamera) {
+      const size_t count = 2000000;
+      const int viewport[4] = {0, 0, 1280, 720};
+
+      std::unique_ptr<InputQueue> queue = std::make_unique<InputQueue>();
+      peasycamera::Camera camera(5.0f);
+      camera.SetDampingMode(peasycamera::DampingMode::TimeBased);
+
+      const Clock::time_point start = Clock::now();
+
+      std::thread producer([&]() {
+         Random random;
+         for (size_t i = 0; i < count; ++i) {
+            const peasycamera::InputEvent event = SyntheticEvent(random);
+            while (!queue->Push(event)) {
+               std::this_thread::yield();
+            }
+         }
+      });
+
+      size_t received = 0;
+      while (received < count) {
+         const size_t consumed = updateCamera ? peasycamera::Update(camera, *queue, viewport) : queue->Consume(Clock::now(), [](std::span<peasycamera::InputEvent>, float) { });
+         received += consumed;
+         if (consumed == 0) {
+            std::this_thread::yield();
+         }
+      }
+      producer.join();
+
+      const double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+      g_sink += camera.m_state.m_rotation.x;
+      printf("input queue throughput, %s: %6.2f M events/s\n", updateCamera ? "drained into Camera::Update" : "drain only", double(count) / seconds * 1e-6);
+   }
+
+   // A producer thread pushes at rateInHz like a polled mouse and the consumer drains as
+   // often as it can; reports how long events sit in the queue.
+   void BenchmarkInputQueueLatency(int rateInHz) {
+      const size_t count = size_t(rateInHz) / 2;
+
+      std::unique_ptr<InputQueue> queue = std::make_unique<InputQueue>();
+      std::vector<double> latencies;
+      latencies.reserve(count);
+
+      std::thread producer([&]() {
+         Random random;
+         const Clock::duration period = std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(1.0 / rateInHz));
+         Clock::time_point next = Clock::now();
+         for (size_t i = 0; i < count; ++i) {
+            while (Clock::now() < next) {
+               std::this_thread::yield();
+            }
+            queue->Push(SyntheticEvent(random));
+            next += period;
+         }
+      });
+
+      while (latencies.size() < count) {
+         const size_t consumed = queue->Consume(Clock::now(), [&](std::span<peasycamera::InputEvent> events, float deltaTimeInSeconds) {
+            for (const peasycamera::InputEvent& event : events) {
+               latencies.push_back(1e6 * double(deltaTimeInSeconds - event.timeInSeconds));
+            }
+         });
+         if (consumed == 0) {
+            std::this_thread::yield();
+         }
+      }
+      producer.join();
+
+      std::sort(latencies.begin(), latencies.end());
+      printf("input queue latency, %5d Hz producer: p50 %8.2f us, p99 %8.2f us, max %8.2f us\n", rateInHz, latencies[latencies.size() / 2], latencies[latencies.size() * 99 / 100], latencies.back());
+   }
+
+   // Records frameCount frames of dragging into a session file, then maps it and replays it.
+   void BenchmarkSessionReplay(uint64_t frameCount, const char* path) {
+      Random random;
+      const std::vector<peasycamera::Input> inputs = DragInputs(1000, random);
+
+      peasycamera::Camera recorded(5.0f);
+      peasycamera::SessionRecorder recorder;
+      if (!recorder.Open(path)) {
+         printf("session replay: cannot write %s\n", path);
+         return;
+      }
+      recorder.Attach(recorded);
+
+      const Clock::time_point recordStart = Clock::now();
+      for (uint64_t frame = 0; frame < frameCount; ++frame) {
+         recorded.Update(inputs[frame % inputs.size()]);
+      }
+      recorder.Close();
+      const double recordSeconds = std::chrono::duration<double>(Clock::now() - recordStart).count();
+      if (recorder.m_writeFailed) {
+         printf("session replay: writing %s failed\n", path);
+         remove(path);
+         return;
+      }
+
+      peasycamera::SessionReplay replay;
+      if (!replay.Open(path)) {
+         printf("session replay: cannot map %s\n", path);
+         return;
+      }
+
+      const double decode = NanosecondsPerItem(size_t(frameCount), 5, [&]() {
+         for (uint64_t frame = 0; frame < replay.GetFrameCount(); ++frame) {
+            g_sink += replay.GetInput(frame).deltaTimeInSeconds;
+         }
+      });
+
+      peasycamera::Camera replayed(5.0f);
+      const double update = NanosecondsPerItem(size_t(frameCount), 5, [&]() {
+         replay.Seek(replayed, 0);
+         replay.Replay(replayed, 0, replay.GetFrameCount());
+      });
+
+      const bool identical = memcmp(&replayed.m_state, &recorded.m_state, sizeof(peasycamera::CameraState)) == 0;
+      printf("session, %llu frames, %.1f MB: record %.1f ms, decode %.1f ms, replay into Camera %.1f ms, %s\n", (unsigned long long)frameCount, double(replay.m_size) / (1 << 20),
+             recordSeconds * 1e3, decode * double(frameCount) * 1e-6, update * double(frameCount) * 1e-6, identical ? "identical" : "DIVERGED");
+
+      replay.Close();
+      remove(path);
+   }
+
+   // Encodes the path of a camera that is dragged around for a while and then left to settle,
+   // over and over, and decodes it again.
+   void BenchmarkPathCodec(size_t frameCount) {
+      Random random;
+      const std::vector<peasycamera::Input> drag = DragInputs(1000, random);
+      peasycamera::Input idle = drag[0];
+      idle.leftMouseButtonDown = false;
+
+      std::vector<peasycamera::CameraState> states(frameCount);
+      peasycamera::Camera camera(5.0f);
+      for (size_t i = 0; i < frameCount; ++i) {
+         camera.Update((i / 300) % 2 == 0 ? drag[i % drag.size()] : idle);
+         states[i] = camera.m_state;
+      }
+
+      peasycamera::PathEncoder encoder;
+      const Clock::time_point encodeStart = Clock::now();
+      for (const peasycamera::CameraState& state : states) {
+         encoder.Add(state);
+      }
+      const double encode = std::chrono::duration<double, std::nano>(Clock::now() - encodeStart).count() / double(frameCount);
+
+      std::vector<peasycamera::CameraState> decoded(frameCount);
+      const double decode = NanosecondsPerItem(frameCount, 5, [&]() {
+         peasycamera::PathDecoder decoder;
+         decoder.Open(encoder.m_bytes.data(), encoder.m_bytes.size());
+         decoder.Decode(decoded.data(), frameCount);
+         g_sink += decoded[frameCount - 1].m_distance;
+      });
+
+      printf("path codec, %zu frames: %.2f bytes/frame (raw %zu), encode %.1f ns/frame, decode %.1f ns/frame, worst error rotation %.3g rad, look-at %.3g, distance %.3g relative\n", frameCount,
+             encoder.GetBytesPerFrame(), sizeof(peasycamera::CameraState), encode, decode, encoder.m_error.m_rotationInRadians, encoder.m_error.m_lookAt, encoder.m_error.m_distance);
+   }
+
+   // userCount simulated users, each with its own trace generator and camera, for frameCount
+   // frames of input generation plus a parallel batch update.
+   void BenchmarkSimulatedUsers(size_t userCount, int frameCount, unsigned threads) {
+      peasycamera::TraceSettings settings;
+      settings.m_frameTimeJitter = 0.05f;
+
+      std::vector<peasycamera::TraceGenerator> generators;
+      generators.reserve(userCount);
+      peasycamera::CameraBatch batch;
+      for (size_t i = 0; i < userCount; ++i) {
+         generators.emplace_back(settings, i);
+         batch.Add(peasycamera::Camera(10.0f));
+      }
+
+      peasycamera::ThreadPool pool(threads);
+      std::vector<peasycamera::Input> inputs(userCount);
+      double generateSeconds = 0.0;
+      double updateSeconds = 0.0;
+
+      for (int frame = 0; frame < frameCount; ++frame) {
+         const Clock::time_point start = Clock::now();
+         for (size_t i = 0; i < userCount; ++i) {
+            inputs[i] = generators[i].Next();
+         }
+         const Clock::time_point generated = Clock::now();
+         peasycamera::UpdateAll(pool, batch, inputs);
+         const Clock::time_point updated = Clock::now();
+
+         generateSeconds += std::chrono::duration<double>(generated - start).count();
+         updateSeconds += std::chrono::duration<double>(updated - generated).count();
+      }
+
+      g_sink += batch.m_state[0].m_distance;
+      printf("simulated users, %zu users, %u threads: generate %.2f ms/frame, update %.2f ms/frame, %zu of %zu cameras awake after %d frames\n", userCount, threads,
+             1e3 * generateSeconds / frameCount, 1e3 * updateSeconds / frameCount, batch.ActiveCount(), userCount, frameCount);
+   }
+
+   // Per-stage totals of everything above, with -DPEASYCAMERA_INSTRUMENT=1.
+   void PrintInstrumentation() {
+      const peasycamera::InstrumentationSnapshot snapshot = peasycamera::GetInstrumentationSnapshot();
+      if (snapshot.m_ticksPerSecond <= 0.0) {
+         return;
+      }
+
+      for (size_t i = 0; i < size_t(peasycamera::Stage::Count); ++i) {
+         const peasycamera::StageCounters& stage = snapshot.m_stages[i];
+         const double ns = stage.m_calls > 0 ? 1e9 * double(stage.m_ticks) / snapshot.m_ticksPerSecond / double(stage.m_calls) : 0.0;
+         printf("instrumentation, %-22s %12llu calls, %8.2f ns/call, %8.1f ms total\n", peasycamera::GetStageName(peasycamera::Stage(i)), (unsigned long long)stage.m_calls, ns,
+                1e3 * double(stage.m_ticks) / snapshot.m_ticksPerSecond);
+      }
+   }
+}
+
+int main() {
+   const unsigned maxThreads = std::thread::hardware_concurrency() > 0 ? std::thread::hardware_concurrency() : 1;
+
+   bool passed = CheckTimeBasedDamping();
+   passed = CheckPrediction() && passed;
+   passed = CheckBatch(300, 600) && passed;
+   passed = CheckParallelUpdate(10000, 120, maxThreads) && passed;
+   passed = CheckShiftDragLock() && passed;
+
+   for (size_t count : {size_t(1000), size_t(100000), size_t(1000000)}) {
+      passed = BenchmarkViewMatrices(count) && passed;
+   }
+
+   for (size_t count : {size_t(1000), size_t(10000), size_t(100000), size_t(1000000)}) {
+      BenchmarkParallelUpdate(count, maxThreads);
+   }
+
+   for (int rate : {1000, 8000}) {
+      BenchmarkInputEvents(rate, peasycamera::DampingMode::PerUpdate);
+      BenchmarkInputEvents(rate, peasycamera::DampingMode::TimeBased);
+      BenchmarkInputEvents(rate, peasycamera::DampingMode::Spring);
+   }
+
+   BenchmarkInputQueueThroughput(false);
+   BenchmarkInputQueueThroughput(true);
+   for (int rate : {1000, 8000}) {
+      BenchmarkInputQueueLatency(rate);
+   }
+
+   BenchmarkSimulatedUsers(100000, 120, maxThreads);
+   BenchmarkPathCodec(1000000);
+   BenchmarkSessionReplay(1000000, "peasycamera_benchmark.pcsr");
+
+   PrintInstrumentation();
+
+   return !passed || g_sink == 12345.0f ? 1 : 0;
+}
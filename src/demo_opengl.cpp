@@ -373,7 +373,6 @@ int __stdcall WinMain(HINSTANCE instance, HINSTANCE ignored, LPSTR cmdLine, int
          input.deltaTimeInSeconds = deltaTime;
 
          cameras[i].Update(input);
-         cameras[i].CalculateViewMatrix();
 
          glViewport(viewports[i].x, viewports[i].y, viewports[i].width, viewports[i].height);
 
@@ -389,7 +388,7 @@ int __stdcall WinMain(HINSTANCE instance, HINSTANCE ignored, LPSTR cmdLine, int
          glUseProgram(program);
 
          glUniformMatrix4fv(glGetUniformLocation(program, "u_world_from_local_matrix"), 1, GL_FALSE, reinterpret_cast<GLfloat*>(&uploadLocalToWorldMatrix));
-         glUniformMatrix4fv(glGetUniformLocation(program, "u_view_from_world_matrix"), 1, GL_FALSE, cameras[i].m_viewMatrix);
+         glUniformMatrix4fv(glGetUniformLocation(program, "u_view_from_world_matrix"), 1, GL_FALSE, cameras[i].GetViewMatrix());
          glUniformMatrix4fv(glGetUniformLocation(program, "u_projection_from_view_matrix"), 1, GL_FALSE, reinterpret_cast<GLfloat*>(&uploadViewToProjectionMatrix));
 
          glBindVertexArray(vao);
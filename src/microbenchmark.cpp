@@ -0,0 +1,311 @@
+// Standalone microbenchmarks of the hot functions in peasycamera.cpp, printed as JSON so runs
+// can be compared against a baseline. Not part of the Visual Studio demo project. The library
+// is compiled into this file to reach the math helpers in its anonymous namespace, so do not
+// link peasycamera.cpp as well.
+//
+//    g++ -std=c++20 -O2 -mavx2 src/microbenchmark.cpp src/peasycamera_instrument.cpp -o microbenchmark && ./microbenchmark > results.json
+//    cl /std:c++latest /O2 /arch:AVX2 src\microbenchmark.cpp src\peasycamera_instrument.cpp
+//
+// Add -DPEASYCAMERA_FAST_MATH=1 (/DPEASYCAMERA_FAST_MATH=1) to time the polynomial math. The
+// SinCos entries and the error fields compare FastSinCos with libm in either build.
+
+#include "peasycamera.cpp"
+
+#include <algorithm>
+#include <chrono>
+#include <vector>
+#include <stdio.h>
+
+namespace {
+   using Clock = std::chrono::steady_clock;
+
+   // Keeps the compiler from discarding or hoisting a result.
+   template <typename T>
+   void DoNotOptimize(const T& value) {
+#if defined(__GNUC__) || defined(__clang__)
+      asm volatile("" : : "r,m"(value) : "memory");
+#else
+      static volatile char sink;
+      sink = *reinterpret_cast<const volatile char*>(&value);
+#endif
+   }
+
+   struct Random {
+      unsigned int m_state = 0x12345678u;
+
+      float Next() {
+         m_state ^= m_state << 13;
+         m_state ^= m_state >> 17;
+         m_state ^= m_state << 5;
+         return float(m_state & 0xffffff) / float(0xffffff) * 2.0f - 1.0f;
+      }
+   };
+
+   peasycamera::quat RandomRotation(Random& random) {
+      return peasycamera::Normalize(peasycamera::quat {random.Next(), random.Next(), random.Next(), random.Next() + 2.0f});
+   }
+
+   struct Result {
+      const char* m_name;
+      size_t m_opsPerSample;
+      double m_mean;
+      double m_min;
+      double m_p50;
+      double m_p90;
+      double m_p99;
+      double m_max;
+   };
+
+   constexpr int kSampleCount = 200;
+   constexpr double kSampleTargetNanoseconds = 20000.0;
+   constexpr double kWarmUpNanoseconds = 10000000.0;
+   constexpr int kCalibrationRuns = 5;
+
+   // Times samples of op(i) for consecutive i. op first runs for kWarmUpNanoseconds to fault in
+   // its data and settle the clock speed. The ops per sample are then doubled until the fastest
+   // of kCalibrationRuns samples takes kSampleTargetNanoseconds, so neither clock overhead nor a
+   // single slow run decides the sample size.
+   template <typename Function>
+   Result Measure(const char* name, Function&& op) {
+      size_t index = 0;
+
+      auto Time = [&](size_t ops) {
+         const Clock::time_point start = Clock::now();
+         for (size_t i = 0; i < ops; ++i) {
+            op(index++);
+         }
+         return std::chrono::duration<double, std::nano>(Clock::now() - start).count();
+      };
+
+      const Clock::time_point warmUpStart = Clock::now();
+      while (std::chrono::duration<double, std::nano>(Clock::now() - warmUpStart).count() < kWarmUpNanoseconds) {
+         Time(64);
+      }
+
+      size_t opsPerSample = 1;
+      for (;;) {
+         double ns = Time(opsPerSample);
+         for (int run = 1; run < kCalibrationRuns; ++run) {
+            ns = std::min(ns, Time(opsPerSample));
+         }
+
+         if (ns >= kSampleTargetNanoseconds || opsPerSample >= (size_t(1) << 24)) {
+            break;
+         }
+         opsPerSample *= 2;
+      }
+
+      std::vector<double> samples(kSampleCount);
+      for (double& sample : samples) {
+         sample = Time(opsPerSample) / double(opsPerSample);
+      }
+
+      double sum = 0.0;
+      for (double sample : samples) {
+         sum += sample;
+      }
+      std::sort(samples.begin(), samples.end());
+
+      auto Percentile = [&](int percent) { return samples[(samples.size() - 1) * percent / 100]; };
+      return {name, opsPerSample, sum / double(samples.size()), samples.front(), Percentile(50), Percentile(90), Percentile(99), samples.back()};
+   }
+
+   constexpr size_t kInputCount = 1024;
+   constexpr size_t kInputMask = kInputCount - 1;
+
+   peasycamera::Input BaseInput() {
+      peasycamera::Input input = { };
+      input.viewport[2] = 1280;
+      input.viewport[3] = 720;
+      input.mouseX = 640;
+      input.mouseY = 360;
+      input.deltaTimeInSeconds = 1.0f / 60.0f;
+      return input;
+   }
+
+   enum class Pattern { Idle, OrbitDrag, Pan, WheelZoom, Animating };
+
+   std::vector<peasycamera::Input> PatternInputs(Pattern pattern, Random& random) {
+      std::vector<peasycamera::Input> inputs(kInputCount, BaseInput());
+      for (peasycamera::Input& input : inputs) {
+         input.mouseX = 640 + int(300.0f * random.Next());
+         input.mouseY = 360 + int(200.0f * random.Next());
+
+         if (pattern == Pattern::OrbitDrag || pattern == Pattern::Pan) {
+            input.mouseDX = int(8.0f * random.Next());
+            input.mouseDY = int(8.0f * random.Next());
+            input.leftMouseButtonDown = (pattern == Pattern::OrbitDrag);
+            input.middleMouseButtonDown = (pattern == Pattern::Pan);
+         } else if (pattern == Pattern::WheelZoom) {
+            // Alternate in and out so the distance stays inside its limits.
+            input.mouseWheelDelta = (&input - inputs.data()) % 2 == 0 ? 1 : -1;
+         }
+      }
+      return inputs;
+   }
+
+   Result MeasureUpdate(const char* name, Pattern pattern) {
+      Random random;
+      const std::vector<peasycamera::Input> inputs = PatternInputs(pattern, random);
+      const peasycamera::CameraState targets[2] = {
+         {RandomRotation(random), {1.0f, 2.0f, 3.0f}, 8.0f},
+         {RandomRotation(random), {-3.0f, 0.0f, 1.0f}, 4.0f},
+      };
+
+      peasycamera::Camera camera(5.0f);
+      for (int i = 0; i < 120; ++i) {
+         camera.Update(BaseInput());
+      }
+
+      return Measure(name, [&](size_t i) {
+         // Keep an animation running: start the next one before the current one finishes.
+         if (pattern == Pattern::Animating && (i & 63) == 0) {
+            camera.SetState(targets[(i >> 6) & 1], 2.0f);
+         }
+         camera.Update(inputs[i & kInputMask]);
+         DoNotOptimize(camera.m_state);
+      });
+   }
+
+   void PrintJson(const std::vector<Result>& results, double libmError, double fastError) {
+#if PEASYCAMERA_SIMD_AVX2
+      const char* simd = "avx2";
+#elif PEASYCAMERA_SIMD_SSE2
+      const char* simd = "sse2";
+#else
+      const char* simd = "none";
+#endif
+
+      printf("{\n");
+      printf("  \"simd\": \"%s\",\n", simd);
+      printf("  \"fast_math\": %s,\n", PEASYCAMERA_FAST_MATH ? "true" : "false");
+      printf("  \"sincos_max_error\": {\"libm\": %.3g, \"fast\": %.3g},\n", libmError, fastError);
+      printf("  \"samples\": %d,\n", kSampleCount);
+      printf("  \"benchmarks\": [\n");
+      for (size_t i = 0; i < results.size(); ++i) {
+         const Result& r = results[i];
+         printf("    {\"name\": \"%s\", \"ops_per_sample\": %zu, \"ops_per_second\": %.0f, \"ns_per_op\": {\"mean\": %.3f, \"min\": %.3f, \"p50\": %.3f, \"p90\": %.3f, \"p99\": %.3f, \"max\": %.3f}}%s\n",
+                r.m_name, r.m_opsPerSample, 1e9 / r.m_p50, r.m_mean, r.m_min, r.m_p50, r.m_p90, r.m_p99, r.m_max, i + 1 < results.size() ? "," : "");
+      }
+      printf("  ]\n");
+      printf("}\n");
+   }
+}
+
+int main() {
+   Random random;
+
+   std::vector<peasycamera::quat> rotations(kInputCount);
+   std::vector<peasycamera::vec3> vectors(kInputCount);
+   std::vector<peasycamera::CameraState> states(kInputCount);
+   std::vector<float> angles(kInputCount);
+   for (size_t i = 0; i < kInputCount; ++i) {
+      rotations[i] = RandomRotation(random);
+      vectors[i] = {random.Next(), random.Next(), random.Next()};
+      states[i] = {rotations[i], {10.0f * random.Next(), 10.0f * random.Next(), 10.0f * random.Next()}, 5.0f + 4.0f * random.Next()};
+      angles[i] = 3.14159265f * random.Next();
+   }
+
+   std::vector<Result> results;
+
+   results.push_back(MeasureUpdate("Camera::Update/idle", Pattern::Idle));
+   results.push_back(MeasureUpdate("Camera::Update/orbit_drag", Pattern::OrbitDrag));
+   results.push_back(MeasureUpdate("Camera::Update/pan", Pattern::Pan));
+   results.push_back(MeasureUpdate("Camera::Update/wheel_zoom", Pattern::WheelZoom));
+   results.push_back(MeasureUpdate("Camera::Update/animating", Pattern::Animating));
+
+   peasycamera::Camera camera(5.0f);
+   results.push_back(Measure("Camera::CalculateViewMatrix", [&](size_t i) {
+      camera.m_state = states[i & kInputMask];
+      camera.CalculateViewMatrix();
+      DoNotOptimize(camera.m_viewMatrix);
+   }));
+
+   // ViewMatrix is the closed-form basis that replaced LookAtMatrix.
+   results.push_back(Measure("ViewMatrix", [&](size_t i) {
+      float matrix[16];
+      peasycamera::ViewMatrix(states[i & kInputMask], matrix);
+      DoNotOptimize(matrix);
+   }));
+
+   results.push_back(Measure("SLerp", [&](size_t i) {
+      const peasycamera::quat q = peasycamera::SLerp(rotations[i & kInputMask], rotations[(i + 1) & kInputMask], 0.5f * (angles[i & kInputMask] + 3.2f) / 3.2f);
+      DoNotOptimize(q);
+   }));
+
+   results.push_back(Measure("FastSLerp", [&](size_t i) {
+      const peasycamera::quat q = peasycamera::FastSLerp(rotations[i & kInputMask], rotations[(i + 1) & kInputMask], 0.5f * (angles[i & kInputMask] + 3.2f) / 3.2f);
+      DoNotOptimize(q);
+   }));
+
+   // Structure of arrays copies of the SLerp benchmark pairs, reported per pair.
+   std::vector<float> slerpStart[4];
+   std::vector<float> slerpEnd[4];
+   std::vector<float> slerpResult[4];
+   std::vector<float> slerpBlend(kInputCount);
+   for (int c = 0; c < 4; ++c) {
+      slerpStart[c].resize(kInputCount);
+      slerpEnd[c].resize(kInputCount);
+      slerpResult[c].resize(kInputCount);
+      for (size_t i = 0; i < kInputCount; ++i) {
+         slerpStart[c][i] = (&rotations[i].x)[c];
+         slerpEnd[c][i] = (&rotations[(i + 1) & kInputMask].x)[c];
+      }
+   }
+   for (size_t i = 0; i < kInputCount; ++i) {
+      slerpBlend[i] = 0.5f * (angles[i] + 3.2f) / 3.2f;
+   }
+
+   const float* slerpA[4] = {slerpStart[0].data(), slerpStart[1].data(), slerpStart[2].data(), slerpStart[3].data()};
+   const float* slerpB[4] = {slerpEnd[0].data(), slerpEnd[1].data(), slerpEnd[2].data(), slerpEnd[3].data()};
+   float* slerpOut[4] = {slerpResult[0].data(), slerpResult[1].data(), slerpResult[2].data(), slerpResult[3].data()};
+
+   Result slerpRotations = Measure("SLerpRotations", [&](size_t) {
+      peasycamera::SLerpRotations(slerpA, slerpB, slerpBlend.data(), kInputCount, slerpOut);
+      DoNotOptimize(slerpResult[0][0]);
+   });
+   slerpRotations.m_opsPerSample *= kInputCount;
+   for (double* value : {&slerpRotations.m_mean, &slerpRotations.m_min, &slerpRotations.m_p50, &slerpRotations.m_p90, &slerpRotations.m_p99, &slerpRotations.m_max}) {
+      *value /= double(kInputCount);
+   }
+   results.push_back(slerpRotations);
+
+   results.push_back(Measure("QuatFromAxisAndAngle", [&](size_t i) {
+      const peasycamera::quat q = peasycamera::QuatFromAxisAndAngle(peasycamera::YAxis, angles[i & kInputMask]);
+      DoNotOptimize(q);
+   }));
+
+   results.push_back(Measure("ApplyRotation", [&](size_t i) {
+      const peasycamera::vec3 v = peasycamera::ApplyRotation(rotations[i & kInputMask], vectors[i & kInputMask]);
+      DoNotOptimize(v);
+   }));
+
+   results.push_back(Measure("SinCos/libm", [&](size_t i) {
+      const float a = 4.0f * angles[i & kInputMask];
+      const float sc[2] = {sinf(a), cosf(a)};
+      DoNotOptimize(sc);
+   }));
+
+   results.push_back(Measure("SinCos/fast", [&](size_t i) {
+      float sc[2];
+      peasycamera::FastSinCos(4.0f * angles[i & kInputMask], sc[0], sc[1]);
+      DoNotOptimize(sc);
+   }));
+
+   // Largest absolute error against double precision over [-4pi, 4pi].
+   double libmError = 0.0;
+   double fastError = 0.0;
+   for (int i = 0; i <= 1000000; ++i) {
+      const float a = float(4.0 * 3.14159265358979 * (2.0 * i / 1000000.0 - 1.0));
+      const double s = sin(double(a));
+      const double c = cos(double(a));
+
+      float fastSin, fastCos;
+      peasycamera::FastSinCos(a, fastSin, fastCos);
+      libmError = std::max({libmError, fabs(sinf(a) - s), fabs(cosf(a) - c)});
+      fastError = std::max({fastError, fabs(fastSin - s), fabs(fastCos - c)});
+   }
+
+   PrintJson(results, libmError, fastError);
+   return 0;
+}
@@ -1,7 +1,23 @@
 #include "peasycamera.h"
+#include "peasycamera_instrument.h"
 #include <math.h>
 #include <assert.h>
 
+#if !defined(PEASYCAMERA_NO_SIMD) && defined(__AVX2__)
+   #define PEASYCAMERA_SIMD_AVX2 1
+   #include <immintrin.h>
+#elif !defined(PEASYCAMERA_NO_SIMD) && (defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2))
+   #define PEASYCAMERA_SIMD_SSE2 1
+   #include <emmintrin.h>
+#endif
+
+// Build with PEASYCAMERA_FAST_MATH=1 to replace the libm sines and cosines of the rotation math
+// with the polynomials below. See FastSinCos for the error bounds. Camera and CameraBatch share
+// the kernels, so they stay bit-identical to each other in either mode.
+#ifndef PEASYCAMERA_FAST_MATH
+   #define PEASYCAMERA_FAST_MATH 0
+#endif
+
 namespace peasycamera {
    namespace {
       constexpr vec3 XAxis = {1.0f, 0.0f, 0.0f};
@@ -12,12 +28,16 @@ namespace peasycamera {
       vec3 operator -(const vec3& a, const vec3& b) { return {a.x - b.x, a.y - b.y, a.z - b.z}; }
       vec3 operator *(float a, const vec3& b) { return {a * b.x, a * b.y, a * b.z}; }
 
-      vec3 CrossProduct(const vec3& a, const vec3& b) { return {a.y * b.z - a.z * b.y, a.z * b.x - a.x * b.z, a.x * b.y - a.y * b.x}; }
       float Length(const vec3& a) { return sqrtf(a.x * a.x + a.y * a.y + a.z * a.z); }
-      vec3 Normalize(const vec3& a) { return (1.0f / Length(a)) * a; }
 
       float Clamp(float value, float min, float max) { return value < min ? min : value > max ? max : value; }
 
+      bool Equal(const CameraState& a, const CameraState& b) {
+         return a.m_rotation.x == b.m_rotation.x && a.m_rotation.y == b.m_rotation.y && a.m_rotation.z == b.m_rotation.z && a.m_rotation.w == b.m_rotation.w &&
+                a.m_lookAt.x == b.m_lookAt.x && a.m_lookAt.y == b.m_lookAt.y && a.m_lookAt.z == b.m_lookAt.z &&
+                a.m_distance == b.m_distance;
+      }
+
       quat operator *(const quat& a, const quat& b) {
          return {
             b.x * a.w + b.w * a.x + (b.y * a.z - b.z * a.y),
@@ -48,17 +68,99 @@ namespace peasycamera {
          };
       }
 
+      // Sine and cosine of angle from one range reduction. The angle is reduced to [-pi/4, pi/4]
+      // by a three-part pi/2 and the quadrant picks the sign and order of the Cephes minimax
+      // polynomials. The measured absolute error is below 1e-7 for |angle| < 8192, against 3.3e-8
+      // for libm, and grows with the reduction error past that.
+      [[maybe_unused]] void FastSinCos(float angle, float& outSin, float& outCos) {
+         const float quadrant = floorf(angle * 0.636619772f + 0.5f);
+         const float x = ((angle - quadrant * 1.5703125f) - quadrant * 4.837512969970703125e-4f) - quadrant * 7.54978995489188216e-8f;
+         const float x2 = x * x;
+
+         const float s = x + x * x2 * (-1.6666654611e-1f + x2 * (8.3321608736e-3f + x2 * -1.9515295891e-4f));
+         const float c = 1.0f - 0.5f * x2 + x2 * x2 * (4.166664568298827e-2f + x2 * (-1.388731625493765e-3f + x2 * 2.443315711809948e-5f));
+
+         switch (int(quadrant) & 3) {
+            case 0: outSin = s; outCos = c; break;
+            case 1: outSin = c; outCos = -s; break;
+            case 2: outSin = -s; outCos = -c; break;
+            default: outSin = -c; outCos = s; break;
+         }
+      }
+
+      void SinCos(float angle, float& outSin, float& outCos) {
+#if PEASYCAMERA_FAST_MATH
+         FastSinCos(angle, outSin, outCos);
+#else
+         outSin = sinf(angle);
+         outCos = cosf(angle);
+#endif
+      }
+
+      float Sin(float angle) {
+#if PEASYCAMERA_FAST_MATH
+         float s, c;
+         FastSinCos(angle, s, c);
+         return s;
+#else
+         return sinf(angle);
+#endif
+      }
+
+      // Half angles below this use the Taylor series. The dropped terms are under 3e-9, so the
+      // error is float rounding, 3e-8.
+      constexpr float kSmallHalfAngle = 0.0625f;
+
+      void HalfAngleSinCos(float halfAngle, float& outSin, float& outCos) {
+#if PEASYCAMERA_FAST_MATH
+         // The per-update rotations are almost always this small.
+         if (fabsf(halfAngle) < kSmallHalfAngle) {
+            const float h2 = halfAngle * halfAngle;
+            outSin = halfAngle * (1.0f - h2 * (1.0f / 6.0f) * (1.0f - h2 * (1.0f / 20.0f)));
+            outCos = 1.0f - h2 * 0.5f * (1.0f - h2 * (1.0f / 12.0f));
+            return;
+         }
+#endif
+         SinCos(halfAngle, outSin, outCos);
+      }
+
       quat QuatFromAxisAndAngle(const vec3& axis, float angle) {
          float len = Length(axis);
          assert(len != 0.0f);
 
          const float half_angle = -0.5f * angle;
-         const float coeff = sinf(half_angle) / len;
 
-         return {coeff * axis.x, coeff * axis.y, coeff * axis.z, cosf(half_angle)};
+         float sinHalf, cosHalf;
+         HalfAngleSinCos(half_angle, sinHalf, cosHalf);
+
+         const float coeff = sinHalf / len;
+
+         return {coeff * axis.x, coeff * axis.y, coeff * axis.z, cosHalf};
+      }
+
+      // Turns rotation by the rotation vector (angleX, angleY, angleZ): the exponential map, one
+      // sincos and one product instead of rotating about X, Y and Z in turn. The result gets one
+      // Newton step toward unit length, scaling by (3 - |q|^2) / 2, so rounding errors do not pile
+      // up over long sessions.
+      quat ApplyRotationVector(const quat& rotation, float angleX, float angleY, float angleZ) {
+         const float angleSquared = angleX * angleX + angleY * angleY + angleZ * angleZ;
+         if (angleSquared == 0.0f) {
+            return rotation;
+         }
+
+         const float angle = sqrtf(angleSquared);
+
+         float sinHalf, cosHalf;
+         HalfAngleSinCos(-0.5f * angle, sinHalf, cosHalf);
+
+         const float coeff = sinHalf / angle;
+         const quat result = rotation * quat {coeff * angleX, coeff * angleY, coeff * angleZ, cosHalf};
+
+         const float lengthSquared = result.x * result.x + result.y * result.y + result.z * result.z + result.w * result.w;
+         return (1.5f - 0.5f * lengthSquared) * result;
       }
 
-      quat SLerp(const quat& a, const quat& b, float t) {
+      [[maybe_unused]] quat SLerp(const quat& a, const quat& b, float t) {
          const float a0 = a.x;
          const float a1 = a.y;
          const float a2 = a.z;
@@ -84,8 +186,8 @@ namespace peasycamera {
 
          float w1, w2;
          if (sinTheta > 0.001f) {
-            w1 = sinf((1.0f - t) * theta) / sinTheta;
-            w2 = sinf(t * theta) / sinTheta;
+            w1 = Sin((1.0f - t) * theta) / sinTheta;
+            w2 = Sin(t * theta) / sinTheta;
          } else {
             w1 = 1.0f - t;
             w2 = t;
@@ -95,69 +197,385 @@ namespace peasycamera {
          return Normalize(result);
       }
 
-      void LookAtMatrix(const vec3& position, const vec3& lookAt, const vec3& up, float* outViewMatrix4x4) {
-         const vec3 zAxis = Normalize(lookAt - position);
-         const vec3 xAxis = Normalize(CrossProduct(zAxis, up));
-         const vec3 yAxis = CrossProduct(xAxis, zAxis);
+      float SignOf(float a) { return copysignf(1.0f, a); }
+      float Sqrt(float a) { return sqrtf(a); }
+
+      // Eberly's constant time slerp, "A Fast and Accurate Algorithm for Computing SLERP".
+      // sin(t theta) / sin(theta) is a series in cos(theta) - 1 whose i-th term is the previous one
+      // times (u_i t^2 - v_i)(cos(theta) - 1), u_i = 1 / (i (2i + 1)) and v_i = i / (2i + 1). It is
+      // cut after eight terms and the last pair is scaled by mu to stand in for the tail.
+      constexpr float kSLerpMu = 1.85298109240830f;
+      constexpr float kSLerpU[8] = {1.0f / 3.0f, 1.0f / 10.0f, 1.0f / 21.0f, 1.0f / 36.0f, 1.0f / 55.0f, 1.0f / 78.0f, 1.0f / 105.0f, kSLerpMu / 136.0f};
+      constexpr float kSLerpV[8] = {1.0f / 3.0f, 2.0f / 5.0f, 3.0f / 7.0f, 4.0f / 9.0f, 5.0f / 11.0f, 6.0f / 13.0f, 7.0f / 15.0f, kSLerpMu * 8.0f / 17.0f};
+
+      // Lane-generic like ViewMatrix below, a, b and out hold {x, y, z, w}. The weights are off by
+      // at most 1.9e-5 at theta = pi/2, so the result is within 1.7e-5 radians of the exact slerp
+      // for rotations 180 degrees apart and within float rounding (3.5e-7, as SLerp) up to 90
+      // degrees. t = 0 and t = 1 return a and b up to the final normalize. No branches and no
+      // transcendentals.
+      template <typename F>
+      void FastSLerp(const F* a, const F* b, F t, F* out) {
+         const F one = F(1.0f);
+         const F dot = a[0] * b[0] + a[1] * b[1] + a[2] * b[2] + a[3] * b[3];
+
+         // Go the short way around, as SLerp does.
+         const F sign = SignOf(dot);
+         const F xm1 = dot * sign - one;
+
+         const F d = one - t;
+         const F t2 = t * t;
+         const F d2 = d * d;
+
+         F weightB = one;
+         F weightA = one;
+         for (int i = 7; i >= 0; --i) {
+            weightB = one + (F(kSLerpU[i]) * t2 - F(kSLerpV[i])) * xm1 * weightB;
+            weightA = one + (F(kSLerpU[i]) * d2 - F(kSLerpV[i])) * xm1 * weightA;
+         }
+         weightB = t * weightB * sign;
+         weightA = d * weightA;
 
-         float M[16] = {
-            xAxis.x, yAxis.x, -zAxis.x, 0.0f,
-            xAxis.y, yAxis.y, -zAxis.y, 0.0f,
-            xAxis.z, yAxis.z, -zAxis.z, 0.0f,
-            0.0f, 0.0f, 0.0f, 1.0f,
-         };
+         F result[4];
+         for (int i = 0; i < 4; ++i) {
+            result[i] = weightA * a[i] + weightB * b[i];
+         }
 
-         float T[16] = {
-            1.0f, 0.0f, 0.0f, 0.0f,
-            0.0f, 1.0f, 0.0f, 0.0f,
-            0.0f, 0.0f, 1.0f, 0.0f,
-            -position.x, -position.y, -position.z, 1.0f,
-         };
+         const F inv = one / Sqrt(result[0] * result[0] + result[1] * result[1] + result[2] * result[2] + result[3] * result[3]);
+         for (int i = 0; i < 4; ++i) {
+            out[i] = inv * result[i];
+         }
+      }
 
-         outViewMatrix4x4[0] = M[0] * T[0] + M[4] * T[1] + M[8] * T[2] + M[12] * T[3];
-         outViewMatrix4x4[1] = M[1] * T[0] + M[5] * T[1] + M[9] * T[2] + M[13] * T[3];
-         outViewMatrix4x4[2] = M[2] * T[0] + M[6] * T[1] + M[10] * T[2] + M[14] * T[3];
-         outViewMatrix4x4[3] = M[3] * T[0] + M[7] * T[1] + M[11] * T[2] + M[15] * T[3];
+      [[maybe_unused]] quat FastSLerp(const quat& a, const quat& b, float t) {
+         const float lanesA[4] = {a.x, a.y, a.z, a.w};
+         const float lanesB[4] = {b.x, b.y, b.z, b.w};
+         float result[4];
+         FastSLerp(lanesA, lanesB, t, result);
+         return {result[0], result[1], result[2], result[3]};
+      }
 
-         outViewMatrix4x4[4] = M[0] * T[4] + M[4] * T[5] + M[8] * T[6] + M[12] * T[7];
-         outViewMatrix4x4[5] = M[1] * T[4] + M[5] * T[5] + M[9] * T[6] + M[13] * T[7];
-         outViewMatrix4x4[6] = M[2] * T[4] + M[6] * T[5] + M[10] * T[6] + M[14] * T[7];
-         outViewMatrix4x4[7] = M[3] * T[4] + M[7] * T[5] + M[11] * T[6] + M[15] * T[7];
+      // Lane-generic view matrix kernel. F is float for a single camera or one of the SIMD lane
+      // types below for several cameras at once. state holds the CameraState fields as
+      // {rotation.xyzw, lookAt.xyz, distance}, out receives the 16 view matrix elements.
+      //
+      // The camera basis is the columns of the rotation matrix of the quaternion, so the matrix
+      // is built in closed form instead of rotating Z and Y and re-orthonormalizing them with
+      // normalizes and cross products. s = 2 / |q|^2 keeps the basis orthonormal even when the
+      // rotation has drifted slightly away from unit length.
+      template <typename F>
+      void ViewMatrix(const F* state, F* out) {
+         const F qx = state[0];
+         const F qy = state[1];
+         const F qz = state[2];
+         const F qw = state[3];
+         const F lookAtX = state[4];
+         const F lookAtY = state[5];
+         const F lookAtZ = state[6];
+         const F distance = state[7];
+         const F one = F(1.0f);
+
+         const F s = F(2.0f) / (qx * qx + qy * qy + qz * qz + qw * qw);
+         const F sxx = s * qx * qx;
+         const F syy = s * qy * qy;
+         const F szz = s * qz * qz;
+         const F sxy = s * qx * qy;
+         const F sxz = s * qx * qz;
+         const F syz = s * qy * qz;
+         const F swx = s * qw * qx;
+         const F swy = s * qw * qy;
+         const F swz = s * qw * qz;
+
+         // ApplyRotation(rotation, XAxis), ApplyRotation(rotation, YAxis) and ApplyRotation(rotation, ZAxis).
+         const F xx = one - (syy + szz);
+         const F xy = sxy - swz;
+         const F xz = sxz + swy;
+
+         const F yx = sxy + swz;
+         const F yy = one - (sxx + szz);
+         const F yz = syz - swx;
+
+         const F zx = sxz - swy;
+         const F zy = syz + swx;
+         const F zz = one - (sxx + syy);
+
+         out[0] = xx;
+         out[1] = yx;
+         out[2] = zx;
+         out[3] = F(0.0f);
+
+         out[4] = xy;
+         out[5] = yy;
+         out[6] = zy;
+         out[7] = F(0.0f);
+
+         out[8] = xz;
+         out[9] = yz;
+         out[10] = zz;
+         out[11] = F(0.0f);
+
+         // The camera sits at lookAt + distance * Z, which is orthogonal to X and Y.
+         out[12] = -(xx * lookAtX + xy * lookAtY + xz * lookAtZ);
+         out[13] = -(yx * lookAtX + yy * lookAtY + yz * lookAtZ);
+         out[14] = -(zx * lookAtX + zy * lookAtY + zz * lookAtZ + distance);
+         out[15] = one;
+      }
+
+      void ViewMatrix(const CameraState& state, float* outViewMatrix4x4) {
+         const float lanes[8] = {state.m_rotation.x, state.m_rotation.y, state.m_rotation.z, state.m_rotation.w, state.m_lookAt.x, state.m_lookAt.y, state.m_lookAt.z, state.m_distance};
+         ViewMatrix(lanes, outViewMatrix4x4);
+      }
+
+      // previous * inverse(current) for two view matrices from ViewMatrix. Both are rigid, so the
+      // inverse is the transposed rotation and the rotated, negated translation.
+      void ReprojectionMatrix(const float* current, const float* previous, float* out) {
+         for (int column = 0; column < 3; ++column) {
+            for (int row = 0; row < 3; ++row) {
+               out[4 * column + row] = previous[row] * current[column] + previous[4 + row] * current[4 + column] + previous[8 + row] * current[8 + column];
+            }
+            out[4 * column + 3] = 0.0f;
+         }
+
+         for (int row = 0; row < 3; ++row) {
+            out[12 + row] = previous[12 + row] - (out[row] * current[12] + out[4 + row] * current[13] + out[8 + row] * current[14]);
+         }
+         out[15] = 1.0f;
+      }
+
+#if PEASYCAMERA_SIMD_AVX2
+      struct FloatX8 {
+         __m256 v;
+
+         FloatX8() = default;
+         FloatX8(__m256 value) : v(value) { }
+         explicit FloatX8(float value) : v(_mm256_set1_ps(value)) { }
+      };
+
+      FloatX8 operator +(FloatX8 a, FloatX8 b) { return _mm256_add_ps(a.v, b.v); }
+      FloatX8 operator -(FloatX8 a, FloatX8 b) { return _mm256_sub_ps(a.v, b.v); }
+      FloatX8 operator *(FloatX8 a, FloatX8 b) { return _mm256_mul_ps(a.v, b.v); }
+      FloatX8 operator /(FloatX8 a, FloatX8 b) { return _mm256_div_ps(a.v, b.v); }
+      FloatX8 operator -(FloatX8 a) { return _mm256_xor_ps(a.v, _mm256_set1_ps(-0.0f)); }
+      FloatX8 SignOf(FloatX8 a) { return _mm256_or_ps(_mm256_and_ps(a.v, _mm256_set1_ps(-0.0f)), _mm256_set1_ps(1.0f)); }
+      FloatX8 Sqrt(FloatX8 a) { return _mm256_sqrt_ps(a.v); }
+
+      void Transpose8x8(__m256* rows) {
+         const __m256 t0 = _mm256_unpacklo_ps(rows[0], rows[1]);
+         const __m256 t1 = _mm256_unpackhi_ps(rows[0], rows[1]);
+         const __m256 t2 = _mm256_unpacklo_ps(rows[2], rows[3]);
+         const __m256 t3 = _mm256_unpackhi_ps(rows[2], rows[3]);
+         const __m256 t4 = _mm256_unpacklo_ps(rows[4], rows[5]);
+         const __m256 t5 = _mm256_unpackhi_ps(rows[4], rows[5]);
+         const __m256 t6 = _mm256_unpacklo_ps(rows[6], rows[7]);
+         const __m256 t7 = _mm256_unpackhi_ps(rows[6], rows[7]);
+
+         const __m256 s0 = _mm256_shuffle_ps(t0, t2, _MM_SHUFFLE(1, 0, 1, 0));
+         const __m256 s1 = _mm256_shuffle_ps(t0, t2, _MM_SHUFFLE(3, 2, 3, 2));
+         const __m256 s2 = _mm256_shuffle_ps(t1, t3, _MM_SHUFFLE(1, 0, 1, 0));
+         const __m256 s3 = _mm256_shuffle_ps(t1, t3, _MM_SHUFFLE(3, 2, 3, 2));
+         const __m256 s4 = _mm256_shuffle_ps(t4, t6, _MM_SHUFFLE(1, 0, 1, 0));
+         const __m256 s5 = _mm256_shuffle_ps(t4, t6, _MM_SHUFFLE(3, 2, 3, 2));
+         const __m256 s6 = _mm256_shuffle_ps(t5, t7, _MM_SHUFFLE(1, 0, 1, 0));
+         const __m256 s7 = _mm256_shuffle_ps(t5, t7, _MM_SHUFFLE(3, 2, 3, 2));
+
+         rows[0] = _mm256_permute2f128_ps(s0, s4, 0x20);
+         rows[1] = _mm256_permute2f128_ps(s1, s5, 0x20);
+         rows[2] = _mm256_permute2f128_ps(s2, s6, 0x20);
+         rows[3] = _mm256_permute2f128_ps(s3, s7, 0x20);
+         rows[4] = _mm256_permute2f128_ps(s0, s4, 0x31);
+         rows[5] = _mm256_permute2f128_ps(s1, s5, 0x31);
+         rows[6] = _mm256_permute2f128_ps(s2, s6, 0x31);
+         rows[7] = _mm256_permute2f128_ps(s3, s7, 0x31);
+      }
+
+      // Eight cameras per iteration: transpose the AoS states into lanes, run the kernel and
+      // transpose the 16 result lanes back into eight consecutive matrices.
+      size_t ViewMatrices(const CameraState* states, size_t count, float* out) {
+         static_assert(sizeof(CameraState) == 8 * sizeof(float), "CameraState is loaded as eight floats");
+
+         size_t i = 0;
+         for (; i + 8 <= count; i += 8) {
+            const float* src = &states[i].m_rotation.x;
+
+            __m256 rows[8] = {
+               _mm256_loadu_ps(src + 0), _mm256_loadu_ps(src + 8), _mm256_loadu_ps(src + 16), _mm256_loadu_ps(src + 24),
+               _mm256_loadu_ps(src + 32), _mm256_loadu_ps(src + 40), _mm256_loadu_ps(src + 48), _mm256_loadu_ps(src + 56),
+            };
+            Transpose8x8(rows);
+
+            const FloatX8 lanes[8] = {rows[0], rows[1], rows[2], rows[3], rows[4], rows[5], rows[6], rows[7]};
+
+            FloatX8 result[16];
+            ViewMatrix(lanes, result);
+
+            __m256 low[8] = {result[0].v, result[1].v, result[2].v, result[3].v, result[4].v, result[5].v, result[6].v, result[7].v};
+            __m256 high[8] = {result[8].v, result[9].v, result[10].v, result[11].v, result[12].v, result[13].v, result[14].v, result[15].v};
+            Transpose8x8(low);
+            Transpose8x8(high);
+
+            float* dst = out + 16 * i;
+            _mm256_storeu_ps(dst + 0, low[0]);
+            _mm256_storeu_ps(dst + 8, high[0]);
+            _mm256_storeu_ps(dst + 16, low[1]);
+            _mm256_storeu_ps(dst + 24, high[1]);
+            _mm256_storeu_ps(dst + 32, low[2]);
+            _mm256_storeu_ps(dst + 40, high[2]);
+            _mm256_storeu_ps(dst + 48, low[3]);
+            _mm256_storeu_ps(dst + 56, high[3]);
+            _mm256_storeu_ps(dst + 64, low[4]);
+            _mm256_storeu_ps(dst + 72, high[4]);
+            _mm256_storeu_ps(dst + 80, low[5]);
+            _mm256_storeu_ps(dst + 88, high[5]);
+            _mm256_storeu_ps(dst + 96, low[6]);
+            _mm256_storeu_ps(dst + 104, high[6]);
+            _mm256_storeu_ps(dst + 112, low[7]);
+            _mm256_storeu_ps(dst + 120, high[7]);
+         }
+         return i;
+      }
+
+      // Eight rotation pairs per iteration, already in lanes.
+      size_t SLerpLanes(const float* const a[4], const float* const b[4], const float* t, size_t count, float* const out[4]) {
+         size_t i = 0;
+         for (; i + 8 <= count; i += 8) {
+            const FloatX8 lanesA[4] = {_mm256_loadu_ps(a[0] + i), _mm256_loadu_ps(a[1] + i), _mm256_loadu_ps(a[2] + i), _mm256_loadu_ps(a[3] + i)};
+            const FloatX8 lanesB[4] = {_mm256_loadu_ps(b[0] + i), _mm256_loadu_ps(b[1] + i), _mm256_loadu_ps(b[2] + i), _mm256_loadu_ps(b[3] + i)};
 
-         outViewMatrix4x4[8] = M[0] * T[8] + M[4] * T[9] + M[8] * T[10] + M[12] * T[11];
-         outViewMatrix4x4[9] = M[1] * T[8] + M[5] * T[9] + M[9] * T[10] + M[13] * T[11];
-         outViewMatrix4x4[10] = M[2] * T[8] + M[6] * T[9] + M[10] * T[10] + M[14] * T[11];
-         outViewMatrix4x4[11] = M[3] * T[8] + M[7] * T[9] + M[11] * T[10] + M[15] * T[11];
+            FloatX8 result[4];
+            FastSLerp(lanesA, lanesB, FloatX8(_mm256_loadu_ps(t + i)), result);
+
+            for (int c = 0; c < 4; ++c) {
+               _mm256_storeu_ps(out[c] + i, result[c].v);
+            }
+         }
+         return i;
+      }
+#elif PEASYCAMERA_SIMD_SSE2
+      struct FloatX4 {
+         __m128 v;
+
+         FloatX4() = default;
+         FloatX4(__m128 value) : v(value) { }
+         explicit FloatX4(float value) : v(_mm_set1_ps(value)) { }
+      };
+
+      FloatX4 operator +(FloatX4 a, FloatX4 b) { return _mm_add_ps(a.v, b.v); }
+      FloatX4 operator -(FloatX4 a, FloatX4 b) { return _mm_sub_ps(a.v, b.v); }
+      FloatX4 operator *(FloatX4 a, FloatX4 b) { return _mm_mul_ps(a.v, b.v); }
+      FloatX4 operator /(FloatX4 a, FloatX4 b) { return _mm_div_ps(a.v, b.v); }
+      FloatX4 operator -(FloatX4 a) { return _mm_xor_ps(a.v, _mm_set1_ps(-0.0f)); }
+      FloatX4 SignOf(FloatX4 a) { return _mm_or_ps(_mm_and_ps(a.v, _mm_set1_ps(-0.0f)), _mm_set1_ps(1.0f)); }
+      FloatX4 Sqrt(FloatX4 a) { return _mm_sqrt_ps(a.v); }
+
+      // Four cameras per iteration, see the AVX2 version above.
+      size_t ViewMatrices(const CameraState* states, size_t count, float* out) {
+         static_assert(sizeof(CameraState) == 8 * sizeof(float), "CameraState is loaded as eight floats");
+
+         size_t i = 0;
+         for (; i + 4 <= count; i += 4) {
+            const float* src = &states[i].m_rotation.x;
+
+            __m128 q0 = _mm_loadu_ps(src + 0);
+            __m128 q1 = _mm_loadu_ps(src + 8);
+            __m128 q2 = _mm_loadu_ps(src + 16);
+            __m128 q3 = _mm_loadu_ps(src + 24);
+            __m128 l0 = _mm_loadu_ps(src + 4);
+            __m128 l1 = _mm_loadu_ps(src + 12);
+            __m128 l2 = _mm_loadu_ps(src + 20);
+            __m128 l3 = _mm_loadu_ps(src + 28);
+            _MM_TRANSPOSE4_PS(q0, q1, q2, q3);
+            _MM_TRANSPOSE4_PS(l0, l1, l2, l3);
+
+            const FloatX4 lanes[8] = {q0, q1, q2, q3, l0, l1, l2, l3};
+
+            FloatX4 result[16];
+            ViewMatrix(lanes, result);
+
+            float* dst = out + 16 * i;
+            for (int quarter = 0; quarter < 4; ++quarter) {
+               __m128 r0 = result[4 * quarter + 0].v;
+               __m128 r1 = result[4 * quarter + 1].v;
+               __m128 r2 = result[4 * quarter + 2].v;
+               __m128 r3 = result[4 * quarter + 3].v;
+               _MM_TRANSPOSE4_PS(r0, r1, r2, r3);
+
+               _mm_storeu_ps(dst + 0 + 4 * quarter, r0);
+               _mm_storeu_ps(dst + 16 + 4 * quarter, r1);
+               _mm_storeu_ps(dst + 32 + 4 * quarter, r2);
+               _mm_storeu_ps(dst + 48 + 4 * quarter, r3);
+            }
+         }
+         return i;
+      }
+
+      // Four rotation pairs per iteration.
+      size_t SLerpLanes(const float* const a[4], const float* const b[4], const float* t, size_t count, float* const out[4]) {
+         size_t i = 0;
+         for (; i + 4 <= count; i += 4) {
+            const FloatX4 lanesA[4] = {_mm_loadu_ps(a[0] + i), _mm_loadu_ps(a[1] + i), _mm_loadu_ps(a[2] + i), _mm_loadu_ps(a[3] + i)};
+            const FloatX4 lanesB[4] = {_mm_loadu_ps(b[0] + i), _mm_loadu_ps(b[1] + i), _mm_loadu_ps(b[2] + i), _mm_loadu_ps(b[3] + i)};
+
+            FloatX4 result[4];
+            FastSLerp(lanesA, lanesB, FloatX4(_mm_loadu_ps(t + i)), result);
+
+            for (int c = 0; c < 4; ++c) {
+               _mm_storeu_ps(out[c] + i, result[c].v);
+            }
+         }
+         return i;
+      }
+#else
+      size_t ViewMatrices(const CameraState*, size_t, float*) {
+         return 0;
+      }
 
-         outViewMatrix4x4[12] = M[0] * T[12] + M[4] * T[13] + M[8] * T[14] + M[12] * T[15];
-         outViewMatrix4x4[13] = M[1] * T[12] + M[5] * T[13] + M[9] * T[14] + M[13] * T[15];
-         outViewMatrix4x4[14] = M[2] * T[12] + M[6] * T[13] + M[10] * T[14] + M[14] * T[15];
-         outViewMatrix4x4[15] = M[3] * T[12] + M[7] * T[13] + M[11] * T[14] + M[15] * T[15];
+      size_t SLerpLanes(const float* const*, const float* const*, const float*, size_t, float* const*) {
+         return 0;
       }
+#endif
 
       float Linear(float a, float b, float t) { return a + t * (b - a); }
       vec3 Linear(const vec3& a, const vec3& b, float t) { return a + t * (b - a); }
       float Smooth(float a, float b, float t) { return a + t * t * (3.0f - 2.0f * t) * (b - a); }
       vec3 Smooth(const vec3& a, const vec3& b, float t) { return {Smooth(a.x, b.x, t), Smooth(a.y, b.y, t), Smooth(a.z, b.z, t)}; }
 
-      void AddMouseWheelZoomImpulse(DampedAction& zoom, float zoomScale, int mouseWheelDelta) {
-         zoom.m_velocity += zoomScale * float(mouseWheelDelta);
+      // Normalized linear blend the short way around; close enough to SLerp for the small steps
+      // between two fixed updates.
+      quat NLerp(const quat& a, const quat& b, float t) {
+         const float sign = (a.x * b.x + a.y * b.y + a.z * b.z + a.w * b.w) < 0.0f ? -1.0f : 1.0f;
+         return Normalize({a.x + t * (sign * b.x - a.x), a.y + t * (sign * b.y - a.y), a.z + t * (sign * b.z - a.z), a.w + t * (sign * b.w - a.w)});
       }
 
-      void AddMouseMoveZoomImpulse(DampedAction& zoom, int mouseDY) {
-         zoom.m_velocity += float(mouseDY) / 10.0f;
+      void AddMouseWheelZoomImpulse(float& zoomVelocity, float zoomScale, float mouseWheelDelta) {
+         zoomVelocity += zoomScale * mouseWheelDelta;
       }
 
-      void AddMouseMovePanImpulse(DampedAction& panX, DampedAction& panY, int dx, int dy) {
-         panX.m_velocity += float(dx) / 8.0f;
-         panY.m_velocity += float(-dy) / 8.0f;
+      void AddMouseMoveZoomImpulse(float& zoomVelocity, float mouseDY) {
+         zoomVelocity += mouseDY / 10.0f;
       }
 
-      void AddMouseMoveRotateImpulse(DampedAction& rotateX, DampedAction& rotateY, DampedAction& rotateZ, Constraint constraint, float distance, int mouseX, int mouseY, int mouseDX, int mouseDY, int viewportLeft, int viewportTop, int viewportWidth, int viewportHeight) {
-         float mult = -powf(log10f(1.0f + distance), 0.5f) * 0.0005f; //0.00125f;
+      void AddMouseMovePanImpulse(float& panXVelocity, float& panYVelocity, float dx, float dy) {
+         panXVelocity += dx / 8.0f;
+         panYVelocity += -dy / 8.0f;
+      }
+
+      // Drag to rotation scale at distance. It only changes with the distance, which stays put
+      // while orbiting, so the last result is kept in cachedDistance and cachedScale.
+      float RotateScale(float distance, float& cachedDistance, float& cachedScale) {
+         if (distance != cachedDistance) {
+#if PEASYCAMERA_FAST_MATH
+            cachedScale = -sqrtf(log10f(1.0f + distance)) * 0.0005f;
+#else
+            cachedScale = -powf(log10f(1.0f + distance), 0.5f) * 0.0005f; //0.00125f;
+#endif
+            cachedDistance = distance;
+         }
+         return cachedScale;
+      }
 
-         float dmx = float(mouseDX) * mult;
-         float dmy = float(mouseDY) * mult;
+      void AddMouseMoveRotateImpulse(float& rotateXVelocity, float& rotateYVelocity, float& rotateZVelocity, Constraint constraint, float mult, float mouseX, float mouseY, float mouseDX, float mouseDY, int viewportLeft, int viewportTop, int viewportWidth, int viewportHeight) {
+
+         float dmx = mouseDX * mult;
+         float dmy = mouseDY * mult;
 
          float viewX = float(viewportLeft);
          float viewY = float(viewportTop);
@@ -165,93 +583,382 @@ namespace peasycamera {
          float viewH = float(viewportHeight);
 
          // mouse [-1, +1]
-         float mxNDC = Clamp((float(mouseX) - viewX) / viewW, 0.0f, 1.0f) * 2.0f - 1.0f;
-         float myNDC = Clamp((float(mouseY) - viewY) / viewH, 0.0f, 1.0f) * 2.0f - 1.0f;
+         float mxNDC = Clamp((mouseX - viewX) / viewW, 0.0f, 1.0f) * 2.0f - 1.0f;
+         float myNDC = Clamp((mouseY - viewY) / viewH, 0.0f, 1.0f) * 2.0f - 1.0f;
 
          if (constraint == Constraint::None || constraint == Constraint::Pitch || constraint == Constraint::SuppressRoll) {
-            rotateX.m_velocity += -dmy * (1.0f - mxNDC * mxNDC);
+            rotateXVelocity += -dmy * (1.0f - mxNDC * mxNDC);
          }
 
          if (constraint == Constraint::None || constraint == Constraint::Yaw || constraint == Constraint::SuppressRoll) {
-            rotateY.m_velocity += dmx * (1.0f - myNDC * myNDC);
+            rotateYVelocity += dmx * (1.0f - myNDC * myNDC);
          }
 
          if (constraint == Constraint::None || constraint == Constraint::Roll) {
-            rotateZ.m_velocity += -dmx * myNDC;
-            rotateZ.m_velocity += -dmy * mxNDC;
+            rotateZVelocity += -dmx * myNDC;
+            rotateZVelocity += -dmy * mxNDC;
          }
       }
 
-      void ApplyZoomToCamera(Camera& camera) {
-         if (camera.m_zoom.m_velocity == 0.0f) {
-            return;
+      // Updates the drag constraint and accumulates the event's mouse impulses. Shared by both
+      // Camera::Update overloads and CameraBatch so every path stays bit-identical. Returns true if
+      // any velocity was pushed, which is what wakes a sleeping camera.
+      bool OutsideViewport(const InputEvent& event, const int viewport[4]) {
+         return (event.mouseX < float(viewport[0]) || event.mouseX > float(viewport[0] + viewport[2])) ||
+                (event.mouseY < float(viewport[1]) || event.mouseY > float(viewport[1] + viewport[3]));
+      }
+
+      // Locks a shift drag to the axis it mostly moves along once it has moved more than a pixel.
+      void LockShiftDrag(Constraint& dragConstraint, float dx, float dy) {
+         if (dragConstraint == Constraint::None && fabsf(dx - dy) > 1.0f) {
+            dragConstraint = (fabsf(dx) > fabsf(dy) ? Constraint::Yaw : Constraint::Pitch);
          }
+      }
 
-         const float newDistance = camera.m_state.m_distance + camera.m_zoom.m_velocity * camera.m_state.m_distance * 0.02f;
+      // LockShiftDrag for the run of shift-held events that starts at first, on their summed
+      // motion: a fast polling mouse moves less than a pixel per event. Returns the end of the run.
+      size_t LockShiftDrag(std::span<const InputEvent> events, size_t first, const int viewport[4], Constraint& dragConstraint) {
+         float dx = 0.0f;
+         float dy = 0.0f;
+         size_t end = first;
+         for (; end < events.size() && events[end].shiftKeyDown; ++end) {
+            if (!OutsideViewport(events[end], viewport)) {
+               dx += events[end].mouseDX;
+               dy += events[end].mouseDY;
+            }
+         }
 
-         if (newDistance < camera.m_minDistance || newDistance > camera.m_maxDistance) {
-            camera.m_zoom.m_velocity = 0.0f;
+         LockShiftDrag(dragConstraint, dx, dy);
+         return end > first ? end : first + 1;
+      }
+
+      bool AddInputImpulses(const InputEvent& event, const int viewport[4], Constraint& dragConstraint, Constraint permaConstraint, float wheelZoomScale, float distance, float& rotateScaleDistance, float& rotateScale, float& zoomVelocity, float& panXVelocity, float& panYVelocity, float& rotateXVelocity, float& rotateYVelocity, float& rotateZVelocity) {
+         if (OutsideViewport(event, viewport)) {
+            return false;
          }
-         camera.m_state.m_distance = Clamp(newDistance, camera.m_minDistance, camera.m_maxDistance);
 
-         camera.m_zoom.m_velocity *= (1.0f - camera.m_zoom.m_friction);
-         if (fabsf(camera.m_zoom.m_velocity) < 0.001f) {
-            camera.m_zoom.m_velocity = 0.0f;
+         if (event.shiftKeyDown) {
+            LockShiftDrag(dragConstraint, event.mouseDX, event.mouseDY);
+         } else if (permaConstraint != Constraint::None) {
+            dragConstraint = permaConstraint;
+         } else {
+            dragConstraint = Constraint::None;
          }
+
+         const bool mouseMoved = (event.mouseDX != 0.0f || event.mouseDY != 0.0f);
+         bool impulse = false;
+
+         if (event.mouseWheelDelta != 0.0f) {
+            AddMouseWheelZoomImpulse(zoomVelocity, wheelZoomScale, event.mouseWheelDelta);
+            impulse = true;
+         }
+
+         if (event.rightMouseButtonDown) {
+            AddMouseMoveZoomImpulse(zoomVelocity, event.mouseDY);
+            impulse = impulse || (event.mouseDY != 0.0f);
+         }
+
+         if (event.middleMouseButtonDown) {
+            AddMouseMovePanImpulse(panXVelocity, panYVelocity, event.mouseDX, event.mouseDY);
+            impulse = impulse || mouseMoved;
+         }
+
+         if (event.leftMouseButtonDown) {
+            AddMouseMoveRotateImpulse(rotateXVelocity, rotateYVelocity, rotateZVelocity, dragConstraint, RotateScale(distance, rotateScaleDistance, rotateScale), event.mouseX, event.mouseY, event.mouseDX, event.mouseDY, viewport[0], viewport[1], viewport[2], viewport[3]);
+            impulse = impulse || mouseMoved;
+         }
+
+         return impulse;
       }
 
-      void ApplyPanToCamera(Camera& camera) {
-         auto MousePan = [](Camera& camera, float dx, float dy) {
-            // @TODO: Make the pan scale dependent on the viewport size.
-            const float panScale = camera.m_state.m_distance * 0.0025f;
-            dx = (camera.m_dragConstraint == Constraint::Pitch ? 0.0f : -panScale * dx);
-            dy = (camera.m_dragConstraint == Constraint::Yaw ? 0.0f : panScale * dy);
-            camera.Pan(dx, dy);
+      bool AddInputImpulses(const Input& input, Constraint& dragConstraint, Constraint permaConstraint, float wheelZoomScale, float distance, float& rotateScaleDistance, float& rotateScale, float& zoomVelocity, float& panXVelocity, float& panYVelocity, float& rotateXVelocity, float& rotateYVelocity, float& rotateZVelocity) {
+         const InputEvent event = {
+            0.0f, float(input.mouseX), float(input.mouseY), float(input.mouseDX), float(input.mouseDY), float(input.mouseWheelDelta),
+            input.leftMouseButtonDown, input.middleMouseButtonDown, input.rightMouseButtonDown, input.shiftKeyDown,
          };
+         return AddInputImpulses(event, input.viewport, dragConstraint, permaConstraint, wheelZoomScale, distance, rotateScaleDistance, rotateScale, zoomVelocity, panXVelocity, panYVelocity, rotateXVelocity, rotateYVelocity, rotateZVelocity);
+      }
 
-         DampedAction& panX = camera.m_panX;
-         DampedAction& panY = camera.m_panY;
+      // Velocities below this are snapped to zero, unless the action has a rest threshold.
+      constexpr float kVelocityCutoff = 0.001f;
 
-         if (panX.m_velocity != 0.0f) {
-            MousePan(camera, panX.m_velocity, 0.0f);
+      // With a rest threshold the velocity is cut once the glide it has left, velocity / friction,
+      // falls under the threshold.
+      float VelocityCutoff(const DampedAction& action) {
+         return action.m_restThreshold > 0.0f ? action.m_restThreshold * action.m_friction : kVelocityCutoff;
+      }
 
-            panX.m_velocity *= (1.0f - panX.m_friction);
+      void DampVelocity(float& velocity, float friction, float cutoff) {
+         velocity *= (1.0f - friction);
 
-            if (fabsf(panX.m_velocity) < 0.001f) {
-               panX.m_velocity = 0.0f;
-            }
+         if (fabsf(velocity) < cutoff) {
+            velocity = 0.0f;
+         }
+      }
+
+      // 1 + ratio + ratio^2 + ... over count terms, count does not have to be whole.
+      float GeometricSum(float ratio, float count) {
+         return ratio == 1.0f ? count : (1.0f - powf(ratio, count)) / (1.0f - ratio);
+      }
+
+      // Number of PerUpdate steps the action keeps moving for before DampVelocity snaps it to zero.
+      float StepsToRest(const DampedAction& action) {
+         const float ratio = 1.0f - action.m_friction;
+         if (ratio <= 0.0f) {
+            return 1.0f;
+         }
+
+         if (ratio >= 1.0f) {
+            return INFINITY;
          }
 
-         if (panY.m_velocity != 0.0f) {
-            MousePan(camera, 0.0f, panY.m_velocity);
+         const float steps = logf(VelocityCutoff(action) / fabsf(action.m_velocity)) / logf(ratio);
+         return steps < 0.0f ? 1.0f : floorf(steps) + 1.0f;
+      }
 
-            panY.m_velocity *= (1.0f - panY.m_friction);
+      // Updates shorter than a PerUpdate step never cover StepsToRest below the cutoff, so
+      // TimeBased also rests once the glide left, velocity / friction, is under the cutoff.
+      // Small impulses still get to add up before that.
+      float RestingVelocity(const DampedAction& action) {
+         return VelocityCutoff(action) * action.m_friction;
+      }
 
-            if (fabsf(panY.m_velocity) < 0.001f) {
-               panY.m_velocity = 0.0f;
-            }
+      // Fractional PerUpdate steps until the velocity drops under RestingVelocity.
+      float StepsToRestingVelocity(const DampedAction& action) {
+         const float ratio = 1.0f - action.m_friction;
+         if (ratio <= 0.0f || ratio >= 1.0f) {
+            return StepsToRest(action);
          }
+         return fmaxf(logf(RestingVelocity(action) / fabsf(action.m_velocity)) / logf(ratio), 0.0f);
+      }
+
+      // PerUpdate steps that deltaTime covers in TimeBased mode, at most StepsToRest.
+      float TimeBasedSteps(const DampedAction& action, float deltaTimeInSeconds) {
+         const float steps = deltaTimeInSeconds * kDampingReferenceRate;
+         const float stepsToRest = StepsToRest(action);
+         return steps < stepsToRest ? steps : stepsToRest;
+      }
+
+      // omega * settle time of the Spring mode: a critically damped spring released from rest covers
+      // all but (1 + x) e^-x = 0.1% of its offset in that time, so snapping to rest at the end of it
+      // is not noticeable.
+      constexpr float kSpringSettleOmegaTime = 9.2334135f;
+
+      bool Moving(const DampedAction& action) {
+         return action.m_velocity != 0.0f || action.m_settleTimeLeft > 0.0f;
+      }
+
+      void Stop(DampedAction& action) {
+         action.m_velocity = 0.0f;
+         action.m_springOffset = 0.0f;
+         action.m_springRate = 0.0f;
+         action.m_settleTimeLeft = 0.0f;
       }
 
-      quat ApplyRotate(DampedAction& rotate, const vec3& rotationAxis, const quat& currentRotation) {
-         if (rotate.m_velocity == 0.0f) {
-            return currentRotation;
+      // The Spring step of Damp. New impulses move the target by the distance the friction modes
+      // would glide, v / friction, and restart the settle time. The offset x to the target then
+      // follows x(t) = (x0 + (v0 + w x0) t) e^-wt with v0 = -m_springRate.
+      float DampSpring(DampedAction& action, float deltaTimeInSeconds) {
+         if (action.m_velocity != 0.0f) {
+            action.m_springOffset += action.m_friction > 0.0f ? action.m_velocity / action.m_friction : action.m_velocity;
+            action.m_velocity = 0.0f;
+            action.m_settleTimeLeft = action.m_settleTimeInSeconds;
          }
 
-         quat result = currentRotation * QuatFromAxisAndAngle(rotationAxis, rotate.m_velocity);
-         rotate.m_velocity *= (1.0f - rotate.m_friction);
+         // With a rest threshold the spring also stops early once neither the offset nor the
+         // overshoot its rate can still add, about rate / omega, is visible.
+         const float offset = action.m_springOffset;
+         const float omega = kSpringSettleOmegaTime / action.m_settleTimeInSeconds;
+         if (deltaTimeInSeconds >= action.m_settleTimeLeft || fabsf(offset) + fabsf(action.m_springRate) / omega < action.m_restThreshold) {
+            Stop(action);
+            return offset;
+         }
+
+         const float decay = expf(-omega * deltaTimeInSeconds);
+         const float velocity = -action.m_springRate;
+         const float c = velocity + omega * offset;
 
-         if (fabsf(rotate.m_velocity) < 0.001f) {
-            rotate.m_velocity = 0.0f;
+         action.m_springOffset = (offset + c * deltaTimeInSeconds) * decay;
+         action.m_springRate = -(velocity - omega * c * deltaTimeInSeconds) * decay;
+         action.m_settleTimeLeft -= deltaTimeInSeconds;
+
+         return offset - action.m_springOffset;
+      }
+
+      // The TimeBased step of Damp, over a count of PerUpdate steps. Only snap to zero once the
+      // steps to rest are covered: a frame cut short by an input event leaves a fraction of a
+      // step, and the velocity still owes the rest of it.
+      float DampSteps(DampedAction& action, float count) {
+         const float velocity = action.m_velocity;
+         const float ratio = 1.0f - action.m_friction;
+         const float stepsToRest = StepsToRest(action);
+         const float steps = count < stepsToRest ? count : stepsToRest;
+
+         action.m_velocity = steps < stepsToRest ? velocity * powf(ratio, steps) : 0.0f;
+         if (fabsf(action.m_velocity) < RestingVelocity(action)) {
+            action.m_velocity = 0.0f;
          }
 
-         return result;
+         return velocity * GeometricSum(ratio, steps);
       }
 
-      void ApplyRotateToCamera(Camera& camera) {
-         camera.m_state.m_rotation = ApplyRotate(camera.m_rotateX, XAxis, camera.m_state.m_rotation);
-         camera.m_state.m_rotation = ApplyRotate(camera.m_rotateY, YAxis, camera.m_state.m_rotation);
-         camera.m_state.m_rotation = ApplyRotate(camera.m_rotateZ, ZAxis, camera.m_state.m_rotation);
+      // Advances the action by one update and returns the distance it covers. PerUpdate moves by
+      // the velocity and applies the friction once. TimeBased covers deltaTime * kDampingReferenceRate
+      // PerUpdate steps with the closed-form geometric sum, so a 2 s frame costs the same as a 16 ms
+      // one and lands where 120 PerUpdate steps would have.
+      float Damp(DampedAction& action, float deltaTimeInSeconds) {
+         const float velocity = action.m_velocity;
+
+         if (action.m_mode == DampingMode::PerUpdate) {
+            DampVelocity(action.m_velocity, action.m_friction, VelocityCutoff(action));
+            return velocity;
+         }
+
+         if (action.m_mode == DampingMode::Spring) {
+            return DampSpring(action, deltaTimeInSeconds);
+         }
+
+         return DampSteps(action, deltaTimeInSeconds * kDampingReferenceRate);
+      }
+
+      // Time until action comes to rest, frameTime is the dt of a PerUpdate step.
+      float SettleTime(const DampedAction& action, float frameTime) {
+         if (action.m_mode == DampingMode::Spring) {
+            return action.m_velocity != 0.0f ? action.m_settleTimeInSeconds : action.m_settleTimeLeft;
+         }
+
+         if (action.m_velocity == 0.0f) {
+            return 0.0f;
+         }
+
+         const float steps = StepsToRest(action);
+         if (action.m_mode == DampingMode::PerUpdate) {
+            return steps * frameTime;
+         }
+         return (frameTime * kDampingReferenceRate < 1.0f ? fmaxf(steps, StepsToRestingVelocity(action)) : steps) / kDampingReferenceRate;
+      }
+
+      // Units the action moves per second, frameTime is the dt of a PerUpdate step. A Spring moves
+      // its offset at m_springRate, TimeBased at the slope of its geometric sum at the start of
+      // the next frame.
+      float MotionRate(const DampedAction& action, float frameTime) {
+         if (action.m_mode == DampingMode::Spring) {
+            return action.m_springRate;
+         }
+
+         if (action.m_mode == DampingMode::PerUpdate) {
+            return action.m_velocity / frameTime;
+         }
+
+         const float ratio = 1.0f - action.m_friction;
+         const float slope = ratio > 0.0f && ratio < 1.0f ? logf(ratio) / (ratio - 1.0f) : 1.0f;
+         return action.m_velocity * kDampingReferenceRate * slope;
+      }
+
+      // Largest |x| the third-order log series of ZoomLogScale covers, its error is under
+      // x^4 / 4 = 1.6e-6 per step. Terms above it are summed one by one, at most kMaxZoomTerms.
+      constexpr float kZoomSeriesLimit = 0.05f;
+      constexpr int kMaxZoomTerms = 256;
+
+      // Log of the distance scale over count TimeBased zoom steps, x = 0.02 * v. Each PerUpdate step
+      // scales the distance by (1 + x r^k), so the log is G(x) - G(x r^count) with G(x) the sum of
+      // log(1 + x r^k) over all k >= 0: whole steps give the exact product, and fractions of a step
+      // add up to the same total. G is summed term by term while x r^k is large and expanded to
+      // third order after that, where every power of x is a geometric series.
+      float ZoomLogScale(float x, float ratio, float count) {
+         if (x <= -1.0f) {
+            return -INFINITY;
+         }
+
+         if (ratio >= 1.0f) {
+            return count * log1pf(x);
+         }
+
+         const float decay = powf(ratio, count);
+         float logScale = 0.0f;
+         for (int k = 0; k < kMaxZoomTerms && fabsf(x) > kZoomSeriesLimit; ++k) {
+            const float end = x * decay;
+            logScale += log1pf((x - end) / (1.0f + end));
+            x *= ratio;
+         }
+
+         return logScale + x * GeometricSum(ratio, count) - (x * x / 2.0f) * GeometricSum(ratio * ratio, count) + (x * x * x / 3.0f) * GeometricSum(ratio * ratio * ratio, count);
+      }
+
+      void ApplyZoom(DampedAction& zoom, float deltaTimeInSeconds, float& distance, float minDistance, float maxDistance) {
+         if (!Moving(zoom)) {
+            return;
+         }
+
+         float newDistance;
+         if (zoom.m_mode == DampingMode::Spring) {
+            // The log of the distance moves like the other actions, 0.02 per unit as PerUpdate.
+            newDistance = distance * expf(0.02f * DampSpring(zoom, deltaTimeInSeconds));
+         } else if (zoom.m_mode == DampingMode::PerUpdate) {
+            newDistance = distance + zoom.m_velocity * distance * 0.02f;
+            Damp(zoom, deltaTimeInSeconds);
+         } else {
+            const float logScale = ZoomLogScale(0.02f * zoom.m_velocity, 1.0f - zoom.m_friction, TimeBasedSteps(zoom, deltaTimeInSeconds));
+            newDistance = distance * expf(logScale);
+            Damp(zoom, deltaTimeInSeconds);
+         }
+
+         if (newDistance < minDistance || newDistance > maxDistance) {
+            Stop(zoom);
+         }
+         distance = Clamp(newDistance, minDistance, maxDistance);
+      }
+
+      void PanLookAt(CameraState& state, float dx, float dy) {
+         state.m_lookAt = state.m_lookAt + ApplyRotation(state.m_rotation, vec3 {dx, dy, 0.0f});
+      }
+
+      void MousePan(CameraState& state, Constraint dragConstraint, float dx, float dy) {
+         // @TODO: Make the pan scale dependent on the viewport size.
+         const float panScale = state.m_distance * 0.0025f;
+         dx = (dragConstraint == Constraint::Pitch ? 0.0f : -panScale * dx);
+         dy = (dragConstraint == Constraint::Yaw ? 0.0f : panScale * dy);
+         PanLookAt(state, dx, dy);
+      }
+
+      void ApplyPan(DampedAction& panX, DampedAction& panY, float deltaTimeInSeconds, Constraint dragConstraint, CameraState& state) {
+         if (Moving(panX)) {
+            MousePan(state, dragConstraint, Damp(panX, deltaTimeInSeconds), 0.0f);
+         }
+
+         if (Moving(panY)) {
+            MousePan(state, dragConstraint, 0.0f, Damp(panY, deltaTimeInSeconds));
+         }
+      }
+
+      float DampRotate(DampedAction& rotate, float deltaTimeInSeconds) {
+         return Moving(rotate) ? Damp(rotate, deltaTimeInSeconds) : 0.0f;
+      }
+
+      float DampRotateSteps(DampedAction& rotate, float count) {
+         return Moving(rotate) ? DampSteps(rotate, count) : 0.0f;
+      }
+
+      // The three rotate velocities are the angular velocity about the camera axes. PerUpdate steps
+      // turn about a fixed axis while all three glide, so TimeBased ends a rotation vector wherever
+      // an axis comes to rest and turns about the new axis for the rest of the update.
+      quat ApplyRotate(DampedAction& rotateX, DampedAction& rotateY, DampedAction& rotateZ, float deltaTimeInSeconds, const quat& currentRotation) {
+         if (rotateX.m_mode != DampingMode::TimeBased || rotateY.m_mode != DampingMode::TimeBased || rotateZ.m_mode != DampingMode::TimeBased) {
+            return ApplyRotationVector(currentRotation, DampRotate(rotateX, deltaTimeInSeconds), DampRotate(rotateY, deltaTimeInSeconds), DampRotate(rotateZ, deltaTimeInSeconds));
+         }
+
+         quat rotation = currentRotation;
+         float stepsLeft = deltaTimeInSeconds * kDampingReferenceRate;
+         for (int segment = 0; segment < 3 && stepsLeft > 0.0f; ++segment) {
+            float steps = stepsLeft;
+            for (const DampedAction* rotate : {&rotateX, &rotateY, &rotateZ}) {
+               steps = Moving(*rotate) ? fminf(steps, StepsToRest(*rotate)) : steps;
+            }
+
+            rotation = ApplyRotationVector(rotation, DampRotateSteps(rotateX, steps), DampRotateSteps(rotateY, steps), DampRotateSteps(rotateZ, steps));
+            stepsLeft -= steps;
+         }
+         return rotation;
       }
 
       template <typename InterpolatorType, typename ValueType>
@@ -262,30 +969,189 @@ namespace peasycamera {
          interpolator.endValue = endValue;
       }
 
-      float UpdateInterpolation(Interpolator<float>& interpolator, float deltaTimeInSeconds) {
-         interpolator.timeConsumedInSeconds += deltaTimeInSeconds;
-         const float t = interpolator.timeConsumedInSeconds / interpolator.timeInSeconds;
+      float Interpolate(float a, float b, float t) { return Smooth(a, b, t); }
+      vec3 Interpolate(const vec3& a, const vec3& b, float t) { return Smooth(a, b, t); }
+#if PEASYCAMERA_FAST_MATH
+      quat Interpolate(const quat& a, const quat& b, float t) { return FastSLerp(a, b, t); }
+#else
+      quat Interpolate(const quat& a, const quat& b, float t) { return SLerp(a, b, t); }
+#endif
 
-         return t <= 0.99f ? Smooth(interpolator.startValue, interpolator.endValue, t) : interpolator.endValue;
+      bool InterpolationActive(float timeInSeconds, float timeConsumedInSeconds) {
+         return (timeInSeconds > 0.0f) && (timeConsumedInSeconds / timeInSeconds <= 0.99f);
       }
 
-      vec3 UpdateInterpolation(Interpolator<vec3>& interpolator, float deltaTimeInSeconds) {
-         interpolator.timeConsumedInSeconds += deltaTimeInSeconds;
-         const float t = interpolator.timeConsumedInSeconds / interpolator.timeInSeconds;
+      template <typename T>
+      T UpdateInterpolation(float timeInSeconds, float& timeConsumedInSeconds, const T& startValue, const T& endValue, float deltaTimeInSeconds) {
+         timeConsumedInSeconds += deltaTimeInSeconds;
+         const float t = timeConsumedInSeconds / timeInSeconds;
+
+         return t <= 0.99f ? Interpolate(startValue, endValue, t) : endValue;
+      }
+
+      // Time until the Update that lands on the end value.
+      float InterpolationTimeLeft(float timeInSeconds, float timeConsumedInSeconds) {
+         return InterpolationActive(timeInSeconds, timeConsumedInSeconds) ? 0.99f * timeInSeconds - timeConsumedInSeconds : 0.0f;
+      }
+
+      template <typename T>
+      bool InterpolationActive(const Interpolator<T>& interpolator) {
+         return InterpolationActive(interpolator.timeInSeconds, interpolator.timeConsumedInSeconds);
+      }
 
-         return t <= 0.99f ? Smooth(interpolator.startValue, interpolator.endValue, t) : interpolator.endValue;
+      template <typename T>
+      float InterpolationTimeLeft(const Interpolator<T>& interpolator) {
+         return InterpolationTimeLeft(interpolator.timeInSeconds, interpolator.timeConsumedInSeconds);
       }
 
-      quat UpdateInterpolation(Interpolator<quat>& interpolator, float deltaTimeInSeconds) {
-         interpolator.timeConsumedInSeconds += deltaTimeInSeconds;
+      // Derivative of the Smooth blend factor per second.
+      template <typename T>
+      float SmoothRate(const Interpolator<T>& interpolator) {
          const float t = interpolator.timeConsumedInSeconds / interpolator.timeInSeconds;
+         return 6.0f * t * (1.0f - t) / interpolator.timeInSeconds;
+      }
+
+      template <typename T>
+      T UpdateInterpolation(Interpolator<T>& interpolator, float deltaTimeInSeconds) {
+         return UpdateInterpolation(interpolator.timeInSeconds, interpolator.timeConsumedInSeconds, interpolator.startValue, interpolator.endValue, deltaTimeInSeconds);
+      }
+
+      bool Settled(const Camera& camera) {
+         return !Moving(camera.m_zoom) && !Moving(camera.m_panX) && !Moving(camera.m_panY) &&
+                !Moving(camera.m_rotateX) && !Moving(camera.m_rotateY) && !Moving(camera.m_rotateZ) &&
+                !InterpolationActive(camera.m_distanceInterpolator) && !InterpolationActive(camera.m_lookAtInterpolator) && !InterpolationActive(camera.m_rotationInterpolator);
+      }
+
+      struct RestThresholds {
+         float m_pan;
+         float m_zoom;
+         float m_rotate;
+         float m_roll;
+      };
+
+      // The rest thresholds of SetSettleThreshold for viewport, false if it or the field of view is empty.
+      bool CalculateRestThresholds(float settleThresholdInPixels, float tanHalfVerticalFov, const int viewport[4], RestThresholds& out) {
+         if (viewport[2] <= 0 || viewport[3] <= 0 || tanHalfVerticalFov <= 0.0f) {
+            return false;
+         }
+
+         // Pixels per radian around the view direction, and from the viewport center to a corner.
+         const float pixelsPerRadian = 0.5f * float(viewport[3]) / tanHalfVerticalFov;
+         const float halfDiagonal = 0.5f * sqrtf(float(viewport[2]) * float(viewport[2]) + float(viewport[3]) * float(viewport[3]));
+
+         // A pan velocity of 1 moves the look-at point by 0.0025 of the distance, see MousePan, a
+         // zoom velocity of 1 scales the distance by 2% and a rotate velocity of 1 turns by a radian.
+         // Roll and zoom move the viewport corners the most.
+         out.m_pan = settleThresholdInPixels / (0.0025f * pixelsPerRadian);
+         out.m_zoom = settleThresholdInPixels / (0.02f * halfDiagonal);
+         out.m_rotate = settleThresholdInPixels / pixelsPerRadian;
+         out.m_roll = settleThresholdInPixels / halfDiagonal;
+         return true;
+      }
+
+      // Time between two PerUpdate damping steps: the fixed time step if there is one, else the
+      // last Update's dt.
+      float PerUpdateStepTime(const Camera& camera) {
+         if (camera.m_fixedTimeStep > 0.0f) {
+            return camera.m_fixedTimeStep;
+         }
+         return camera.m_lastDeltaTimeInSeconds > 0.0f ? camera.m_lastDeltaTimeInSeconds : 1.0f / kDampingReferenceRate;
+      }
+
+      // Fraction of an Update PredictState still counts as a whole one, for times that are a
+      // multiple of the frame time up to rounding.
+      constexpr float kPredictStepTolerance = 1e-3f;
+
+      // The damped actions, then the interpolators, epoch and sleep state; shared by both
+      // Camera::Update overloads.
+      void ApplyActions(Camera& camera, float deltaTimeInSeconds) {
+         {
+            PEASYCAMERA_INSTRUMENT_SCOPE(Stage::Zoom);
+            ApplyZoom(camera.m_zoom, deltaTimeInSeconds, camera.m_state.m_distance, camera.m_minDistance, camera.m_maxDistance);
+         }
+
+         {
+            PEASYCAMERA_INSTRUMENT_SCOPE(Stage::Pan);
+            ApplyPan(camera.m_panX, camera.m_panY, deltaTimeInSeconds, camera.m_dragConstraint, camera.m_state);
+         }
+
+         PEASYCAMERA_INSTRUMENT_SCOPE(Stage::Rotate);
+         camera.m_state.m_rotation = ApplyRotate(camera.m_rotateX, camera.m_rotateY, camera.m_rotateZ, deltaTimeInSeconds, camera.m_state.m_rotation);
+      }
+
+      void UpdateInterpolators(Camera& camera, float deltaTimeInSeconds) {
+         if (InterpolationActive(camera.m_distanceInterpolator)) {
+            PEASYCAMERA_INSTRUMENT_SCOPE(Stage::DistanceInterpolator);
+            camera.m_state.m_distance = Clamp(UpdateInterpolation(camera.m_distanceInterpolator, deltaTimeInSeconds), camera.m_minDistance, camera.m_maxDistance);
+         }
+
+         if (InterpolationActive(camera.m_lookAtInterpolator)) {
+            PEASYCAMERA_INSTRUMENT_SCOPE(Stage::LookAtInterpolator);
+            camera.m_state.m_lookAt = UpdateInterpolation(camera.m_lookAtInterpolator, deltaTimeInSeconds);
+         }
+
+         if (InterpolationActive(camera.m_rotationInterpolator)) {
+            PEASYCAMERA_INSTRUMENT_SCOPE(Stage::RotationInterpolator);
+            camera.m_state.m_rotation = UpdateInterpolation(camera.m_rotationInterpolator, deltaTimeInSeconds);
+         }
+      }
+
+      void EndUpdate(Camera& camera, const CameraState& previousState) {
+         if (!Equal(previousState, camera.m_state)) {
+            ++camera.m_epoch;
+         }
+         camera.m_previousStateEpoch = camera.m_epoch;
+
+         camera.m_asleep = Settled(camera);
+      }
+
+      void FinishUpdate(Camera& camera, const CameraState& previousState, float deltaTimeInSeconds) {
+         UpdateInterpolators(camera, deltaTimeInSeconds);
+         EndUpdate(camera, previousState);
+      }
+
+      // Steps the actions and interpolators every Camera::m_fixedTimeStep of deltaTimeInSeconds and
+      // carries the remainder over, see Camera::SetFixedTimeStep.
+      void AdvanceFixedSteps(Camera& camera, float deltaTimeInSeconds) {
+         if (camera.m_previousStateEpoch != camera.m_epoch) {
+            camera.m_previousState = camera.m_state;
+         }
+
+         // Nothing to step, and no backlog to replay once something moves again.
+         if (Settled(camera)) {
+            camera.m_fixedTimeLeft = 0.0f;
+            camera.m_previousState = camera.m_state;
+            return;
+         }
 
-         return t <= 0.99f ? SLerp(interpolator.startValue, interpolator.endValue, t) : interpolator.endValue;
+         camera.m_fixedTimeLeft = fminf(camera.m_fixedTimeLeft + deltaTimeInSeconds, kMaxFixedStepCatchUp);
+         while (camera.m_fixedTimeLeft >= camera.m_fixedTimeStep) {
+            camera.m_previousState = camera.m_state;
+            ApplyActions(camera, camera.m_fixedTimeStep);
+            UpdateInterpolators(camera, camera.m_fixedTimeStep);
+            camera.m_fixedTimeLeft -= camera.m_fixedTimeStep;
+
+            if (Settled(camera)) {
+               camera.m_fixedTimeLeft = 0.0f;
+               camera.m_previousState = camera.m_state;
+               break;
+            }
+         }
       }
 
-      template <typename InterpolatorType>
-      bool InterpolationActive(const InterpolatorType& interpolator) {
-         return (interpolator.timeInSeconds > 0.0f) && (interpolator.timeConsumedInSeconds / interpolator.timeInSeconds <= 0.99f);
+      // The rest thresholds of Camera::SetSettleThreshold for viewport.
+      void UpdateRestThresholds(Camera& camera, const int viewport[4]) {
+         RestThresholds thresholds;
+         if (!CalculateRestThresholds(camera.m_settleThresholdInPixels, camera.m_tanHalfVerticalFov, viewport, thresholds)) {
+            return;
+         }
+
+         camera.m_panX.m_restThreshold = thresholds.m_pan;
+         camera.m_panY.m_restThreshold = thresholds.m_pan;
+         camera.m_zoom.m_restThreshold = thresholds.m_zoom;
+         camera.m_rotateX.m_restThreshold = thresholds.m_rotate;
+         camera.m_rotateY.m_restThreshold = thresholds.m_rotate;
+         camera.m_rotateZ.m_restThreshold = thresholds.m_roll;
       }
    }
 
@@ -298,65 +1164,199 @@ namespace peasycamera {
    }
 
    void Camera::CalculateViewMatrix() {
-      vec3 position = m_state.m_distance * ApplyRotation(m_state.m_rotation, ZAxis) + m_state.m_lookAt;
-      vec3 up = ApplyRotation(m_state.m_rotation, YAxis);
-      LookAtMatrix(position, m_state.m_lookAt, up, m_viewMatrix);
+      PEASYCAMERA_INSTRUMENT_SCOPE(Stage::ViewMatrix);
+      const bool firstBuild = m_viewMatrixEpoch == 0;
+      if (!firstBuild && m_viewMatrixUpdateCount != m_updateCount) {
+         for (int i = 0; i < 16; ++i) {
+            m_previousViewMatrix[i] = m_viewMatrix[i];
+         }
+      }
+
+      ViewMatrix(GetRenderState(), m_viewMatrix);
+      m_viewMatrixEpoch = m_epoch;
+      m_viewMatrixUpdateCount = m_updateCount;
+
+      // Nothing to reproject from yet.
+      if (firstBuild) {
+         for (int i = 0; i < 16; ++i) {
+            m_previousViewMatrix[i] = m_viewMatrix[i];
+         }
+      }
+      ReprojectionMatrix(m_viewMatrix, m_previousViewMatrix, m_reprojectionMatrix);
+   }
+
+   const float* Camera::GetViewMatrix() {
+      // Between two fixed steps the render state also moves with m_fixedTimeLeft, which Update
+      // advances without touching m_state.
+      const bool blending = m_fixedTimeStep > 0.0f && m_previousStateEpoch == m_epoch && !Equal(m_previousState, m_state);
+      if (m_viewMatrixEpoch != m_epoch || (blending && m_viewMatrixUpdateCount != m_updateCount)) {
+         CalculateViewMatrix();
+      } else if (m_viewMatrixUpdateCount != m_updateCount) {
+         for (int i = 0; i < 16; ++i) {
+            m_previousViewMatrix[i] = m_viewMatrix[i];
+            m_reprojectionMatrix[i] = (i % 5 == 0) ? 1.0f : 0.0f;
+         }
+         m_viewMatrixUpdateCount = m_updateCount;
+      }
+      return m_viewMatrix;
+   }
+
+   void CalculateViewMatrices(const CameraState* states, size_t count, float* outViewMatrices) {
+      size_t i = ViewMatrices(states, count, outViewMatrices);
+      for (; i < count; ++i) {
+         ViewMatrix(states[i], outViewMatrices + 16 * i);
+      }
+   }
+
+   void SLerpRotations(const float* const a[4], const float* const b[4], const float* t, size_t count, float* const out[4]) {
+      size_t i = SLerpLanes(a, b, t, count, out);
+      for (; i < count; ++i) {
+         const float lanesA[4] = {a[0][i], a[1][i], a[2][i], a[3][i]};
+         const float lanesB[4] = {b[0][i], b[1][i], b[2][i], b[3][i]};
+         float result[4];
+         FastSLerp(lanesA, lanesB, t[i], result);
+         for (int c = 0; c < 4; ++c) {
+            out[c][i] = result[c];
+         }
+      }
+   }
+
+   WakeTime MergeWakeTimes(const WakeTime& a, const WakeTime& b) {
+      if (!a.m_moving || !b.m_moving) {
+         return a.m_moving ? a : b;
+      }
+      return {true, fminf(a.m_nextChangeInSeconds, b.m_nextChangeInSeconds), fmaxf(a.m_restInSeconds, b.m_restInSeconds)};
    }
 
    void Camera::Update(const Input& input) {
-      const bool disableUserInput = (input.mouseX < input.viewport[0] || input.mouseX > input.viewport[0] + input.viewport[2]) ||
-                                    (input.mouseY < input.viewport[1] || input.mouseY > input.viewport[1] + input.viewport[3]);
+      if (m_inputHook) {
+         m_inputHook(m_inputHookContext, *this, input);
+      }
+
+      m_lastDeltaTimeInSeconds = input.deltaTimeInSeconds;
+      ++m_updateCount;
+      if (m_settleThresholdInPixels > 0.0f) {
+         UpdateRestThresholds(*this, input.viewport);
+      }
+
+      bool impulse;
+      {
+         PEASYCAMERA_INSTRUMENT_SCOPE(Stage::Impulses);
+         impulse = AddInputImpulses(input, m_dragConstraint, m_permaConstraint, m_wheelZoomScale, m_state.m_distance, m_rotateScaleDistance, m_rotateScale, m_zoom.m_velocity, m_panX.m_velocity, m_panY.m_velocity, m_rotateX.m_velocity, m_rotateY.m_velocity, m_rotateZ.m_velocity);
+      }
+
+      if (m_asleep && !impulse) {
+         return;
+      }
 
-      if (!disableUserInput) {
-         if (input.shiftKeyDown) {
-            const int dx = input.mouseDX;
-            const int dy = input.mouseDY;
+      const CameraState previousState = m_state;
+      if (m_fixedTimeStep > 0.0f) {
+         AdvanceFixedSteps(*this, input.deltaTimeInSeconds);
+         EndUpdate(*this, previousState);
+         return;
+      }
 
-            if (m_dragConstraint == Constraint::None && abs(input.mouseDX - input.mouseDY) > 1) {
-               m_dragConstraint = (abs(dx) > abs(dy) ? Constraint::Yaw : Constraint::Pitch);
+      ApplyActions(*this, input.deltaTimeInSeconds);
+      FinishUpdate(*this, previousState, input.deltaTimeInSeconds);
+   }
+
+   void Camera::Update(std::span<const InputEvent> events, const int viewport[4], float deltaTimeInSeconds) {
+      m_lastDeltaTimeInSeconds = deltaTimeInSeconds;
+      ++m_updateCount;
+      if (m_settleThresholdInPixels > 0.0f) {
+         UpdateRestThresholds(*this, viewport);
+      }
+
+      const CameraState previousState = m_state;
+      float time = 0.0f;
+      bool impulse = false;
+
+      // Fixed steps run up to each event, whatever the damping mode.
+      if (m_fixedTimeStep > 0.0f) {
+         size_t shiftRunEnd = 0;
+         for (size_t k = 0; k < events.size(); ++k) {
+            const InputEvent& event = events[k];
+            const float eventTime = Clamp(event.timeInSeconds, time, deltaTimeInSeconds);
+            AdvanceFixedSteps(*this, eventTime - time);
+            time = eventTime;
+
+            PEASYCAMERA_INSTRUMENT_SCOPE(Stage::Impulses);
+            if (k >= shiftRunEnd) {
+               shiftRunEnd = LockShiftDrag(events, k, viewport, m_dragConstraint);
+            }
+            if (AddInputImpulses(event, viewport, m_dragConstraint, m_permaConstraint, m_wheelZoomScale, m_state.m_distance, m_rotateScaleDistance, m_rotateScale, m_zoom.m_velocity, m_panX.m_velocity, m_panY.m_velocity, m_rotateX.m_velocity, m_rotateY.m_velocity, m_rotateZ.m_velocity)) {
+               m_asleep = false;
             }
-         } else if (m_permaConstraint != Constraint::None) {
-            m_dragConstraint = m_permaConstraint;
-         } else {
-            m_dragConstraint = Constraint::None;
-         }
-      
-         if (input.mouseWheelDelta != 0) {
-            AddMouseWheelZoomImpulse(m_zoom, m_wheelZoomScale, input.mouseWheelDelta);
          }
 
-         if (input.rightMouseButtonDown) {
-            AddMouseMoveZoomImpulse(m_zoom, input.mouseDY);
-         }
+         AdvanceFixedSteps(*this, deltaTimeInSeconds - time);
+         EndUpdate(*this, previousState);
+         return;
+      }
+
+      size_t shiftRunEnd = 0;
+      for (size_t k = 0; k < events.size(); ++k) {
+         const InputEvent& event = events[k];
+
+         // Bring the TimeBased and Spring actions up to the event; PerUpdate ones wait for the final step.
+         const float eventTime = Clamp(event.timeInSeconds, time, deltaTimeInSeconds);
+         if (eventTime > time) {
+            const float dt = eventTime - time;
+            time = eventTime;
+
+            if (m_zoom.m_mode != DampingMode::PerUpdate) {
+               ApplyZoom(m_zoom, dt, m_state.m_distance, m_minDistance, m_maxDistance);
+            }
+
+            if (m_panX.m_mode != DampingMode::PerUpdate && Moving(m_panX)) {
+               MousePan(m_state, m_dragConstraint, Damp(m_panX, dt), 0.0f);
+            }
 
-         if (input.middleMouseButtonDown) {
-            AddMouseMovePanImpulse(m_panX, m_panY, input.mouseDX, input.mouseDY);
+            if (m_panY.m_mode != DampingMode::PerUpdate && Moving(m_panY)) {
+               MousePan(m_state, m_dragConstraint, 0.0f, Damp(m_panY, dt));
+            }
+
+            const float angleX = m_rotateX.m_mode != DampingMode::PerUpdate ? DampRotate(m_rotateX, dt) : 0.0f;
+            const float angleY = m_rotateY.m_mode != DampingMode::PerUpdate ? DampRotate(m_rotateY, dt) : 0.0f;
+            const float angleZ = m_rotateZ.m_mode != DampingMode::PerUpdate ? DampRotate(m_rotateZ, dt) : 0.0f;
+            m_state.m_rotation = ApplyRotationVector(m_state.m_rotation, angleX, angleY, angleZ);
          }
 
-         if (input.leftMouseButtonDown) {
-            AddMouseMoveRotateImpulse(m_rotateX, m_rotateY, m_rotateZ, m_dragConstraint, m_state.m_distance, input.mouseX, input.mouseY, input.mouseDX, input.mouseDY, input.viewport[0], input.viewport[1], input.viewport[2], input.viewport[3]);
+         PEASYCAMERA_INSTRUMENT_SCOPE(Stage::Impulses);
+         if (k >= shiftRunEnd) {
+            shiftRunEnd = LockShiftDrag(events, k, viewport, m_dragConstraint);
          }
+         impulse = AddInputImpulses(event, viewport, m_dragConstraint, m_permaConstraint, m_wheelZoomScale, m_state.m_distance, m_rotateScaleDistance, m_rotateScale, m_zoom.m_velocity, m_panX.m_velocity, m_panY.m_velocity, m_rotateX.m_velocity, m_rotateY.m_velocity, m_rotateZ.m_velocity) || impulse;
       }
 
-      ApplyZoomToCamera(*this);
-      ApplyPanToCamera(*this);
-      ApplyRotateToCamera(*this);
-
-      if (InterpolationActive(m_distanceInterpolator)) {
-         m_state.m_distance = Clamp(UpdateInterpolation(m_distanceInterpolator, input.deltaTimeInSeconds), m_minDistance, m_maxDistance);
+      if (m_asleep && !impulse) {
+         return;
       }
 
-      if (InterpolationActive(m_lookAtInterpolator)) {
-         m_state.m_lookAt = UpdateInterpolation(m_lookAtInterpolator, input.deltaTimeInSeconds);
-      }
+      // The rest of the frame for TimeBased actions, the single step for PerUpdate ones.
+      ApplyActions(*this, deltaTimeInSeconds - time);
+      FinishUpdate(*this, previousState, deltaTimeInSeconds);
+   }
 
-      if (InterpolationActive(m_rotationInterpolator)) {
-         m_state.m_rotation = UpdateInterpolation(m_rotationInterpolator, input.deltaTimeInSeconds);
+   void Camera::SetFixedTimeStep(float stepInSeconds) {
+      m_fixedTimeStep = stepInSeconds > 0.0f ? stepInSeconds : 0.0f;
+      m_fixedTimeLeft = 0.0f;
+      m_previousState = m_state;
+      m_previousStateEpoch = m_epoch;
+   }
+
+   CameraState Camera::GetRenderState(float secondsSinceUpdate) const {
+      if (m_fixedTimeStep <= 0.0f || m_previousStateEpoch != m_epoch) {
+         return m_state;
       }
+
+      const float t = Clamp((m_fixedTimeLeft + secondsSinceUpdate) / m_fixedTimeStep, 0.0f, 1.0f);
+      return {NLerp(m_previousState.m_rotation, m_state.m_rotation, t), Linear(m_previousState.m_lookAt, m_state.m_lookAt, t), Linear(m_previousState.m_distance, m_state.m_distance, t)};
    }
 
    void Camera::Pan(float dx, float dy) {
-      m_state.m_lookAt = m_state.m_lookAt + ApplyRotation(m_state.m_rotation, vec3 {dx, dy, 0.0f});
+      PanLookAt(m_state, dx, dy);
+      ++m_epoch;
    }
 
    void Camera::GetPosition(float* outX, float* outY, float* outZ) const {
@@ -369,33 +1369,223 @@ namespace peasycamera {
    void Camera::SetDistance(float distance, float animationTimeInSeconds) {
       if (animationTimeInSeconds <= 0.0f) {
          m_state.m_distance = distance;
+         ++m_epoch;
       } else {
          StartInterpolation(m_distanceInterpolator, m_state.m_distance, distance, animationTimeInSeconds);
+         m_asleep = false;
       }
    }
 
    void Camera::SetLookAt(float x, float y, float z, float animationTimeInSeconds) {
       if (animationTimeInSeconds <= 0.0f) {
          m_state.m_lookAt = {x, y, z};
+         ++m_epoch;
       } else {
          StartInterpolation(m_lookAtInterpolator, m_state.m_lookAt, vec3 {x, y, z}, animationTimeInSeconds);
+         m_asleep = false;
       }
    }
 
    void Camera::SetState(const CameraState& state, float animationTimeInSeconds) {
       if (animationTimeInSeconds <= 0.0f) {
          m_state = state;
+         ++m_epoch;
       } else {
          StartInterpolation(m_rotationInterpolator, m_state.m_rotation, state.m_rotation, animationTimeInSeconds);
          StartInterpolation(m_lookAtInterpolator, m_state.m_lookAt, state.m_lookAt, animationTimeInSeconds);
          StartInterpolation(m_distanceInterpolator, m_state.m_distance, state.m_distance, animationTimeInSeconds);
+         m_asleep = false;
       }
    }
 
+   CameraState Camera::PredictState(float secondsAhead) const {
+      if (m_asleep || secondsAhead <= 0.0f) {
+         return m_state;
+      }
+
+      CameraState state = m_state;
+      DampedAction zoom = m_zoom;
+      DampedAction panX = m_panX;
+      DampedAction panY = m_panY;
+      DampedAction rotateX = m_rotateX;
+      DampedAction rotateY = m_rotateY;
+      DampedAction rotateZ = m_rotateZ;
+      Interpolator<float> distanceInterpolator = m_distanceInterpolator;
+      Interpolator<vec3> lookAtInterpolator = m_lookAtInterpolator;
+      Interpolator<quat> rotationInterpolator = m_rotationInterpolator;
+      DampedAction* const actions[] = {&zoom, &panX, &panY, &rotateX, &rotateY, &rotateZ};
+
+      // ApplyActions and UpdateInterpolators on the copies. Between two Updates only the TimeBased
+      // and Spring actions move, so PerUpdate ones are held still unless perUpdate is set.
+      auto Advance = [&](float deltaTimeInSeconds, bool perUpdate) {
+         float velocities[6];
+         for (int i = 0; i < 6; ++i) {
+            velocities[i] = actions[i]->m_velocity;
+            if (!perUpdate && actions[i]->m_mode == DampingMode::PerUpdate) {
+               actions[i]->m_velocity = 0.0f;
+            }
+         }
+
+         ApplyZoom(zoom, deltaTimeInSeconds, state.m_distance, m_minDistance, m_maxDistance);
+         ApplyPan(panX, panY, deltaTimeInSeconds, m_dragConstraint, state);
+         state.m_rotation = ApplyRotate(rotateX, rotateY, rotateZ, deltaTimeInSeconds, state.m_rotation);
+
+         for (int i = 0; i < 6; ++i) {
+            if (!perUpdate && actions[i]->m_mode == DampingMode::PerUpdate) {
+               actions[i]->m_velocity = velocities[i];
+            }
+         }
+
+         if (InterpolationActive(distanceInterpolator)) {
+            state.m_distance = Clamp(UpdateInterpolation(distanceInterpolator, deltaTimeInSeconds), m_minDistance, m_maxDistance);
+         }
+
+         if (InterpolationActive(lookAtInterpolator)) {
+            state.m_lookAt = UpdateInterpolation(lookAtInterpolator, deltaTimeInSeconds);
+         }
+
+         if (InterpolationActive(rotationInterpolator)) {
+            state.m_rotation = UpdateInterpolation(rotationInterpolator, deltaTimeInSeconds);
+         }
+      };
+
+      // Whatever still has to be stepped one Update, or one fixed step, at a time.
+      const bool fixedStep = m_fixedTimeStep > 0.0f;
+      auto Stepping = [&]() {
+         for (const DampedAction* action : actions) {
+            if (Moving(*action) && (fixedStep || action->m_mode == DampingMode::PerUpdate)) {
+               return true;
+            }
+         }
+         return fixedStep && (InterpolationActive(distanceInterpolator) || InterpolationActive(lookAtInterpolator) || InterpolationActive(rotationInterpolator));
+      };
+
+      // Updates come every frameTime, the steps to the last whole one are taken the way Update
+      // takes them until the PerUpdate actions rest. With a fixed time step the steps also cover
+      // m_fixedTimeLeft. The other actions and the interpolators then cover the time left in one
+      // closed-form advance, unless they only move on fixed steps.
+      const float frameTime = PerUpdateStepTime(*this);
+      const int steps = int((fixedStep ? m_fixedTimeLeft + secondsAhead : secondsAhead) / frameTime + kPredictStepTolerance);
+
+      int step = 0;
+      for (; step < steps && Stepping(); ++step) {
+         Advance(frameTime, true);
+      }
+
+      const float timeLeft = secondsAhead - float(step) * frameTime;
+      if (!fixedStep && timeLeft > 0.0f) {
+         Advance(timeLeft, false);
+      }
+
+      return state;
+   }
+
    void Camera::Reset(float animationTimeInSeconds) {
       SetState(m_resetState, animationTimeInSeconds);
    }
 
+   void Camera::SetDampingMode(DampingMode mode) {
+      m_panX.m_mode = mode;
+      m_panY.m_mode = mode;
+      m_zoom.m_mode = mode;
+      m_rotateX.m_mode = mode;
+      m_rotateY.m_mode = mode;
+      m_rotateZ.m_mode = mode;
+   }
+
+   void Camera::SetSettleTime(float settleTimeInSeconds) {
+      m_panX.m_settleTimeInSeconds = settleTimeInSeconds;
+      m_panY.m_settleTimeInSeconds = settleTimeInSeconds;
+      m_zoom.m_settleTimeInSeconds = settleTimeInSeconds;
+      m_rotateX.m_settleTimeInSeconds = settleTimeInSeconds;
+      m_rotateY.m_settleTimeInSeconds = settleTimeInSeconds;
+      m_rotateZ.m_settleTimeInSeconds = settleTimeInSeconds;
+   }
+
+   void Camera::SetSettleThreshold(float pixels, float verticalFovInRadians) {
+      m_settleThresholdInPixels = pixels > 0.0f ? pixels : 0.0f;
+      m_tanHalfVerticalFov = tanf(0.5f * verticalFovInRadians);
+
+      if (m_settleThresholdInPixels == 0.0f) {
+         for (DampedAction* action : {&m_panX, &m_panY, &m_zoom, &m_rotateX, &m_rotateY, &m_rotateZ}) {
+            action->m_restThreshold = 0.0f;
+         }
+      }
+   }
+
+   MotionSignals Camera::GetMotionSignals(const int viewport[4], float verticalFovInRadians) const {
+      MotionSignals motion;
+      if (m_asleep) {
+         return motion;
+      }
+
+      const float frameTime = PerUpdateStepTime(*this);
+      motion.m_angularVelocity = {MotionRate(m_rotateX, frameTime), MotionRate(m_rotateY, frameTime), MotionRate(m_rotateZ, frameTime)};
+      motion.m_zoomRate = 0.02f * MotionRate(m_zoom, frameTime);
+
+      // Same scale and constraint as MousePan.
+      const float panScale = m_state.m_distance * 0.0025f;
+      const float panX = m_dragConstraint == Constraint::Pitch ? 0.0f : -panScale * MotionRate(m_panX, frameTime);
+      const float panY = m_dragConstraint == Constraint::Yaw ? 0.0f : panScale * MotionRate(m_panY, frameTime);
+      motion.m_lookAtVelocity = ApplyRotation(m_state.m_rotation, vec3 {panX, panY, 0.0f});
+
+      if (InterpolationActive(m_distanceInterpolator)) {
+         motion.m_zoomRate += (m_distanceInterpolator.endValue - m_distanceInterpolator.startValue) * SmoothRate(m_distanceInterpolator) / m_state.m_distance;
+      }
+
+      if (InterpolationActive(m_lookAtInterpolator)) {
+         motion.m_lookAtVelocity = motion.m_lookAtVelocity + SmoothRate(m_lookAtInterpolator) * (m_lookAtInterpolator.endValue - m_lookAtInterpolator.startValue);
+      }
+
+      // The rotation interpolates at a constant rate about the axis of start^-1 * end, which is
+      // the same in the camera frame all the way. Rotations hold -angle / 2, see
+      // QuatFromAxisAndAngle.
+      if (InterpolationActive(m_rotationInterpolator)) {
+         const quat& a = m_rotationInterpolator.startValue;
+         quat delta = quat {-a.x, -a.y, -a.z, a.w} * m_rotationInterpolator.endValue;
+         if (delta.w < 0.0f) {
+            delta = -1.0f * delta;
+         }
+
+         const vec3 axis = {delta.x, delta.y, delta.z};
+         const float sinHalfAngle = Length(axis);
+         if (sinHalfAngle > 0.0f) {
+            const float angle = -2.0f * atan2f(sinHalfAngle, delta.w);
+            motion.m_angularVelocity = motion.m_angularVelocity + (angle / (sinHalfAngle * m_rotationInterpolator.timeInSeconds)) * axis;
+         }
+      }
+
+      // Pixels per radian around the view direction, and from the viewport center to a corner;
+      // see CalculateRestThresholds.
+      const float pixelsPerRadian = 0.5f * float(viewport[3]) / tanf(0.5f * verticalFovInRadians);
+      const float halfDiagonal = 0.5f * sqrtf(float(viewport[2]) * float(viewport[2]) + float(viewport[3]) * float(viewport[3]));
+      const vec3& w = motion.m_angularVelocity;
+      motion.m_screenSpeedInPixels = pixelsPerRadian * (sqrtf(w.x * w.x + w.y * w.y) + Length(motion.m_lookAtVelocity) / m_state.m_distance) + halfDiagonal * (fabsf(w.z) + fabsf(motion.m_zoomRate));
+      return motion;
+   }
+
+   float Camera::GetSettleTimeInSeconds() const {
+      const float frameTime = PerUpdateStepTime(*this);
+      float settleTime = 0.0f;
+      for (const DampedAction* action : {&m_panX, &m_panY, &m_zoom, &m_rotateX, &m_rotateY, &m_rotateZ}) {
+         settleTime = fmaxf(settleTime, SettleTime(*action, frameTime));
+      }
+      return settleTime;
+   }
+
+   WakeTime Camera::GetWakeTime() const {
+      WakeTime wake;
+      if (Settled(*this)) {
+         return wake;
+      }
+
+      wake.m_moving = true;
+      wake.m_nextChangeInSeconds = m_fixedTimeStep > 0.0f ? m_fixedTimeStep - m_fixedTimeLeft : 0.0f;
+      wake.m_restInSeconds = fmaxf(fmaxf(GetSettleTimeInSeconds(), InterpolationTimeLeft(m_distanceInterpolator)), fmaxf(InterpolationTimeLeft(m_lookAtInterpolator), InterpolationTimeLeft(m_rotationInterpolator)));
+      wake.m_restInSeconds = fmaxf(wake.m_restInSeconds, wake.m_nextChangeInSeconds);
+      return wake;
+   }
+
    void Camera::SetFreeRotationMode() {
       m_permaConstraint = Constraint::None;
    }
@@ -418,14 +1608,17 @@ namespace peasycamera {
 
    void Camera::RotateX(float radians) {
       m_state.m_rotation = m_state.m_rotation * QuatFromAxisAndAngle(XAxis, radians);
+      ++m_epoch;
    }
 
    void Camera::RotateY(float radians) {
       m_state.m_rotation = m_state.m_rotation * QuatFromAxisAndAngle(YAxis, radians);
+      ++m_epoch;
    }
 
    void Camera::RotateZ(float radians) {
       m_state.m_rotation = m_state.m_rotation * QuatFromAxisAndAngle(ZAxis, radians);
+      ++m_epoch;
    }
 
    void Camera::SetRotations(float rx, float ry, float rz) {
@@ -436,10 +1629,520 @@ namespace peasycamera {
       const quat r3 = QuatFromAxisAndAngle(ZAxis, rz);
       const quat composed = r1 * r2 * r3;
       m_state.m_rotation = composed;
+      ++m_epoch;
    }
 
    void Camera::GetRotations(float* outRX, float* outRY, float* outRZ) const {
       // @TODO:
       assert(!"do this shit");
    }
+
+   namespace {
+      void PushBack(CameraBatch::DampedActionArray& array, const DampedAction& action) {
+         array.m_velocity.push_back(action.m_velocity);
+         array.m_friction.push_back(action.m_friction);
+         array.m_mode.push_back(action.m_mode);
+         array.m_settleTimeInSeconds.push_back(action.m_settleTimeInSeconds);
+         array.m_springOffset.push_back(action.m_springOffset);
+         array.m_springRate.push_back(action.m_springRate);
+         array.m_settleTimeLeft.push_back(action.m_settleTimeLeft);
+         array.m_restThreshold.push_back(action.m_restThreshold);
+      }
+
+      // Writes back what Damp changes.
+      void StoreMotion(CameraBatch::DampedActionArray& array, size_t index, const DampedAction& action) {
+         array.m_velocity[index] = action.m_velocity;
+         array.m_springOffset[index] = action.m_springOffset;
+         array.m_springRate[index] = action.m_springRate;
+         array.m_settleTimeLeft[index] = action.m_settleTimeLeft;
+      }
+
+      void Store(CameraBatch::DampedActionArray& array, size_t index, const DampedAction& action) {
+         array.m_friction[index] = action.m_friction;
+         array.m_mode[index] = action.m_mode;
+         array.m_settleTimeInSeconds[index] = action.m_settleTimeInSeconds;
+         array.m_restThreshold[index] = action.m_restThreshold;
+         StoreMotion(array, index, action);
+      }
+
+      DampedAction Load(const CameraBatch::DampedActionArray& array, size_t index) {
+         DampedAction action;
+         action.m_velocity = array.m_velocity[index];
+         action.m_friction = array.m_friction[index];
+         action.m_mode = array.m_mode[index];
+         action.m_settleTimeInSeconds = array.m_settleTimeInSeconds[index];
+         action.m_springOffset = array.m_springOffset[index];
+         action.m_springRate = array.m_springRate[index];
+         action.m_settleTimeLeft = array.m_settleTimeLeft[index];
+         action.m_restThreshold = array.m_restThreshold[index];
+         return action;
+      }
+
+      template <typename T>
+      void PushBack(CameraBatch::InterpolatorArray<T>& array, const Interpolator<T>& interpolator) {
+         array.timeInSeconds.push_back(interpolator.timeInSeconds);
+         array.timeConsumedInSeconds.push_back(interpolator.timeConsumedInSeconds);
+         array.startValue.push_back(interpolator.startValue);
+         array.endValue.push_back(interpolator.endValue);
+      }
+
+      template <typename T>
+      void Store(CameraBatch::InterpolatorArray<T>& array, size_t index, const Interpolator<T>& interpolator) {
+         array.timeInSeconds[index] = interpolator.timeInSeconds;
+         array.timeConsumedInSeconds[index] = interpolator.timeConsumedInSeconds;
+         array.startValue[index] = interpolator.startValue;
+         array.endValue[index] = interpolator.endValue;
+      }
+
+      template <typename T>
+      Interpolator<T> Load(const CameraBatch::InterpolatorArray<T>& array, size_t index) {
+         Interpolator<T> interpolator;
+         interpolator.timeInSeconds = array.timeInSeconds[index];
+         interpolator.timeConsumedInSeconds = array.timeConsumedInSeconds[index];
+         interpolator.startValue = array.startValue[index];
+         interpolator.endValue = array.endValue[index];
+         return interpolator;
+      }
+
+      template <typename T, typename Allocator>
+      void SwapRemove(std::vector<T, Allocator>& array, size_t index) {
+         array[index] = array.back();
+         array.pop_back();
+      }
+
+      void SwapRemove(CameraBatch::DampedActionArray& array, size_t index) {
+         SwapRemove(array.m_velocity, index);
+         SwapRemove(array.m_friction, index);
+         SwapRemove(array.m_mode, index);
+         SwapRemove(array.m_settleTimeInSeconds, index);
+         SwapRemove(array.m_springOffset, index);
+         SwapRemove(array.m_springRate, index);
+         SwapRemove(array.m_settleTimeLeft, index);
+         SwapRemove(array.m_restThreshold, index);
+      }
+
+      template <typename T>
+      void SwapRemove(CameraBatch::InterpolatorArray<T>& array, size_t index) {
+         SwapRemove(array.timeInSeconds, index);
+         SwapRemove(array.timeConsumedInSeconds, index);
+         SwapRemove(array.startValue, index);
+         SwapRemove(array.endValue, index);
+      }
+
+      template <typename T>
+      bool InterpolationActive(const CameraBatch::InterpolatorArray<T>& array, size_t index) {
+         return InterpolationActive(array.timeInSeconds[index], array.timeConsumedInSeconds[index]);
+      }
+
+      template <typename T>
+      T UpdateInterpolation(CameraBatch::InterpolatorArray<T>& array, size_t index, float deltaTimeInSeconds) {
+         return UpdateInterpolation(array.timeInSeconds[index], array.timeConsumedInSeconds[index], array.startValue[index], array.endValue[index], deltaTimeInSeconds);
+      }
+
+      bool Moving(const CameraBatch::DampedActionArray& array, size_t index) {
+         return array.m_velocity[index] != 0.0f || array.m_settleTimeLeft[index] > 0.0f;
+      }
+
+      bool Settled(const CameraBatch& batch, size_t index) {
+         return !Moving(batch.m_zoom, index) && !Moving(batch.m_panX, index) && !Moving(batch.m_panY, index) &&
+                !Moving(batch.m_rotateX, index) && !Moving(batch.m_rotateY, index) && !Moving(batch.m_rotateZ, index) &&
+                !InterpolationActive(batch.m_distanceInterpolator, index) && !InterpolationActive(batch.m_lookAtInterpolator, index) && !InterpolationActive(batch.m_rotationInterpolator, index);
+      }
+
+      template <typename T>
+      float InterpolationTimeLeft(const CameraBatch::InterpolatorArray<T>& array, size_t index) {
+         return InterpolationTimeLeft(array.timeInSeconds[index], array.timeConsumedInSeconds[index]);
+      }
+
+      template <typename T>
+      void StartInterpolation(CameraBatch::InterpolatorArray<T>& array, size_t index, const T& startValue, const T& endValue, float timeInSeconds) {
+         array.timeInSeconds[index] = timeInSeconds;
+         array.timeConsumedInSeconds[index] = 0.0f;
+         array.startValue[index] = startValue;
+         array.endValue[index] = endValue;
+      }
+
+      // UpdateRestThresholds of a Camera for camera index.
+      void UpdateRestThresholds(CameraBatch& batch, size_t index, const int viewport[4]) {
+         RestThresholds thresholds;
+         if (!CalculateRestThresholds(batch.m_settleThresholdInPixels[index], batch.m_tanHalfVerticalFov[index], viewport, thresholds)) {
+            return;
+         }
+
+         batch.m_panX.m_restThreshold[index] = thresholds.m_pan;
+         batch.m_panY.m_restThreshold[index] = thresholds.m_pan;
+         batch.m_zoom.m_restThreshold[index] = thresholds.m_zoom;
+         batch.m_rotateX.m_restThreshold[index] = thresholds.m_rotate;
+         batch.m_rotateY.m_restThreshold[index] = thresholds.m_rotate;
+         batch.m_rotateZ.m_restThreshold[index] = thresholds.m_roll;
+      }
+   }
+
+   size_t CameraBatch::Add(const Camera& camera) {
+      assert(camera.m_fixedTimeStep <= 0.0f);
+      const size_t index = m_state.size();
+
+      m_state.push_back(camera.m_state);
+      m_resetState.push_back(camera.m_resetState);
+      m_viewMatrix.emplace_back();
+      peasycamera::ViewMatrix(camera.m_state, m_viewMatrix.back().m_elements);
+
+      PushBack(m_panX, camera.m_panX);
+      PushBack(m_panY, camera.m_panY);
+      PushBack(m_zoom, camera.m_zoom);
+      PushBack(m_rotateX, camera.m_rotateX);
+      PushBack(m_rotateY, camera.m_rotateY);
+      PushBack(m_rotateZ, camera.m_rotateZ);
+
+      PushBack(m_distanceInterpolator, camera.m_distanceInterpolator);
+      PushBack(m_lookAtInterpolator, camera.m_lookAtInterpolator);
+      PushBack(m_rotationInterpolator, camera.m_rotationInterpolator);
+
+      m_minDistance.push_back(camera.m_minDistance);
+      m_maxDistance.push_back(camera.m_maxDistance);
+      m_wheelZoomScale.push_back(camera.m_wheelZoomScale);
+      m_rotateScaleDistance.push_back(camera.m_rotateScaleDistance);
+      m_rotateScale.push_back(camera.m_rotateScale);
+      m_settleThresholdInPixels.push_back(camera.m_settleThresholdInPixels);
+      m_tanHalfVerticalFov.push_back(camera.m_tanHalfVerticalFov);
+      m_lastDeltaTimeInSeconds.push_back(camera.m_lastDeltaTimeInSeconds);
+      m_epoch.push_back(camera.m_epoch);
+      m_stepStartState.push_back(camera.m_state);
+
+      m_dragConstraint.push_back(camera.m_dragConstraint);
+      m_permaConstraint.push_back(camera.m_permaConstraint);
+
+      m_awake.push_back(0);
+      if (!camera.m_asleep) {
+         Wake(index);
+      }
+
+      return index;
+   }
+
+   void CameraBatch::Remove(size_t index) {
+      assert(index < Size());
+
+      SwapRemove(m_state, index);
+      SwapRemove(m_resetState, index);
+      SwapRemove(m_viewMatrix, index);
+
+      SwapRemove(m_panX, index);
+      SwapRemove(m_panY, index);
+      SwapRemove(m_zoom, index);
+      SwapRemove(m_rotateX, index);
+      SwapRemove(m_rotateY, index);
+      SwapRemove(m_rotateZ, index);
+
+      SwapRemove(m_distanceInterpolator, index);
+      SwapRemove(m_lookAtInterpolator, index);
+      SwapRemove(m_rotationInterpolator, index);
+
+      SwapRemove(m_minDistance, index);
+      SwapRemove(m_maxDistance, index);
+      SwapRemove(m_wheelZoomScale, index);
+      SwapRemove(m_rotateScaleDistance, index);
+      SwapRemove(m_rotateScale, index);
+      SwapRemove(m_settleThresholdInPixels, index);
+      SwapRemove(m_tanHalfVerticalFov, index);
+      SwapRemove(m_lastDeltaTimeInSeconds, index);
+      SwapRemove(m_epoch, index);
+      SwapRemove(m_stepStartState, index);
+
+      SwapRemove(m_dragConstraint, index);
+      SwapRemove(m_permaConstraint, index);
+
+      // The last camera moved into the removed slot, patch the active list to match.
+      const uint32_t moved = uint32_t(m_awake.size() - 1);
+      for (size_t i = 0; i < m_active.size();) {
+         if (m_active[i] == uint32_t(index)) {
+            SwapRemove(m_active, i);
+            continue;
+         }
+
+         if (m_active[i] == moved) {
+            m_active[i] = uint32_t(index);
+         }
+         ++i;
+      }
+      SwapRemove(m_awake, index);
+   }
+
+   void CameraBatch::Clear() {
+      *this = CameraBatch();
+   }
+
+   Camera CameraBatch::GetCamera(size_t index) const {
+      assert(index < Size());
+
+      Camera camera(m_state[index].m_distance);
+      camera.m_state = m_state[index];
+      camera.m_resetState = m_resetState[index];
+
+      camera.m_panX = Load(m_panX, index);
+      camera.m_panY = Load(m_panY, index);
+      camera.m_zoom = Load(m_zoom, index);
+      camera.m_rotateX = Load(m_rotateX, index);
+      camera.m_rotateY = Load(m_rotateY, index);
+      camera.m_rotateZ = Load(m_rotateZ, index);
+
+      camera.m_distanceInterpolator = Load(m_distanceInterpolator, index);
+      camera.m_lookAtInterpolator = Load(m_lookAtInterpolator, index);
+      camera.m_rotationInterpolator = Load(m_rotationInterpolator, index);
+
+      camera.m_minDistance = m_minDistance[index];
+      camera.m_maxDistance = m_maxDistance[index];
+      camera.m_wheelZoomScale = m_wheelZoomScale[index];
+      camera.m_rotateScaleDistance = m_rotateScaleDistance[index];
+      camera.m_rotateScale = m_rotateScale[index];
+      camera.m_settleThresholdInPixels = m_settleThresholdInPixels[index];
+      camera.m_tanHalfVerticalFov = m_tanHalfVerticalFov[index];
+      camera.m_lastDeltaTimeInSeconds = m_lastDeltaTimeInSeconds[index];
+      camera.m_epoch = m_epoch[index];
+
+      camera.m_dragConstraint = m_dragConstraint[index];
+      camera.m_permaConstraint = m_permaConstraint[index];
+
+      camera.m_asleep = IsAsleep(index);
+
+      return camera;
+   }
+
+   void CameraBatch::SetCamera(size_t index, const Camera& camera) {
+      assert(index < Size());
+      assert(camera.m_fixedTimeStep <= 0.0f);
+
+      m_state[index] = camera.m_state;
+      m_resetState[index] = camera.m_resetState;
+
+      Store(m_panX, index, camera.m_panX);
+      Store(m_panY, index, camera.m_panY);
+      Store(m_zoom, index, camera.m_zoom);
+      Store(m_rotateX, index, camera.m_rotateX);
+      Store(m_rotateY, index, camera.m_rotateY);
+      Store(m_rotateZ, index, camera.m_rotateZ);
+
+      Store(m_distanceInterpolator, index, camera.m_distanceInterpolator);
+      Store(m_lookAtInterpolator, index, camera.m_lookAtInterpolator);
+      Store(m_rotationInterpolator, index, camera.m_rotationInterpolator);
+
+      m_minDistance[index] = camera.m_minDistance;
+      m_maxDistance[index] = camera.m_maxDistance;
+      m_wheelZoomScale[index] = camera.m_wheelZoomScale;
+      m_rotateScaleDistance[index] = camera.m_rotateScaleDistance;
+      m_rotateScale[index] = camera.m_rotateScale;
+      m_settleThresholdInPixels[index] = camera.m_settleThresholdInPixels;
+      m_tanHalfVerticalFov[index] = camera.m_tanHalfVerticalFov;
+      m_lastDeltaTimeInSeconds[index] = camera.m_lastDeltaTimeInSeconds;
+      m_epoch[index] = camera.m_epoch;
+
+      m_dragConstraint[index] = camera.m_dragConstraint;
+      m_permaConstraint[index] = camera.m_permaConstraint;
+
+      Wake(index);
+   }
+
+   void CameraBatch::UpdateAll(std::span<const Input> inputs) {
+      UpdateRange(inputs, 0, Size());
+      RebuildActiveList();
+   }
+
+   void CameraBatch::UpdateRange(std::span<const Input> inputs, size_t begin, size_t end) {
+      assert(inputs.size() == Size());
+      assert(begin <= end && end <= Size());
+
+      for (size_t i = begin; i < end; ++i) {
+         m_lastDeltaTimeInSeconds[i] = inputs[i].deltaTimeInSeconds;
+         if (m_settleThresholdInPixels[i] > 0.0f) {
+            UpdateRestThresholds(*this, i, inputs[i].viewport);
+         }
+
+         AddInputImpulses(inputs[i], m_dragConstraint[i], m_permaConstraint[i], m_wheelZoomScale[i], m_state[i].m_distance, m_rotateScaleDistance[i], m_rotateScale[i], m_zoom.m_velocity[i], m_panX.m_velocity[i], m_panY.m_velocity[i], m_rotateX.m_velocity[i], m_rotateY.m_velocity[i], m_rotateZ.m_velocity[i]);
+         m_stepStartState[i] = m_state[i];
+      }
+
+      for (size_t i = begin; i < end; ++i) {
+         DampedAction zoom = Load(m_zoom, i);
+         ApplyZoom(zoom, inputs[i].deltaTimeInSeconds, m_state[i].m_distance, m_minDistance[i], m_maxDistance[i]);
+         StoreMotion(m_zoom, i, zoom);
+      }
+
+      for (size_t i = begin; i < end; ++i) {
+         DampedAction panX = Load(m_panX, i);
+         DampedAction panY = Load(m_panY, i);
+         ApplyPan(panX, panY, inputs[i].deltaTimeInSeconds, m_dragConstraint[i], m_state[i]);
+         StoreMotion(m_panX, i, panX);
+         StoreMotion(m_panY, i, panY);
+      }
+
+      for (size_t i = begin; i < end; ++i) {
+         DampedAction rotateX = Load(m_rotateX, i);
+         DampedAction rotateY = Load(m_rotateY, i);
+         DampedAction rotateZ = Load(m_rotateZ, i);
+
+         m_state[i].m_rotation = ApplyRotate(rotateX, rotateY, rotateZ, inputs[i].deltaTimeInSeconds, m_state[i].m_rotation);
+
+         StoreMotion(m_rotateX, i, rotateX);
+         StoreMotion(m_rotateY, i, rotateY);
+         StoreMotion(m_rotateZ, i, rotateZ);
+      }
+
+      for (size_t i = begin; i < end; ++i) {
+         if (InterpolationActive(m_distanceInterpolator, i)) {
+            m_state[i].m_distance = Clamp(UpdateInterpolation(m_distanceInterpolator, i, inputs[i].deltaTimeInSeconds), m_minDistance[i], m_maxDistance[i]);
+         }
+      }
+
+      for (size_t i = begin; i < end; ++i) {
+         if (InterpolationActive(m_lookAtInterpolator, i)) {
+            m_state[i].m_lookAt = UpdateInterpolation(m_lookAtInterpolator, i, inputs[i].deltaTimeInSeconds);
+         }
+      }
+
+      for (size_t i = begin; i < end; ++i) {
+         if (InterpolationActive(m_rotationInterpolator, i)) {
+            m_state[i].m_rotation = UpdateInterpolation(m_rotationInterpolator, i, inputs[i].deltaTimeInSeconds);
+         }
+      }
+   
+      // Like EndUpdate for a Camera.
+      for (size_t i = begin; i < end; ++i) {
+         if (!Equal(m_stepStartState[i], m_state[i])) {
+            ++m_epoch[i];
+         }
+         m_awake[i] = Settled(*this, i) ? 0 : 1;
+      }
+   }
+
+   WakeTime CameraBatch::GetWakeTime(float frameTimeInSeconds) const {
+      WakeTime wake;
+      for (uint32_t i : m_active) {
+         if (Settled(*this, i)) {
+            continue;
+         }
+
+         float restInSeconds = fmaxf(fmaxf(InterpolationTimeLeft(m_distanceInterpolator, i), InterpolationTimeLeft(m_lookAtInterpolator, i)), InterpolationTimeLeft(m_rotationInterpolator, i));
+         for (const DampedActionArray* array : {&m_panX, &m_panY, &m_zoom, &m_rotateX, &m_rotateY, &m_rotateZ}) {
+            restInSeconds = fmaxf(restInSeconds, SettleTime(Load(*array, i), frameTimeInSeconds));
+         }
+         wake = MergeWakeTimes(wake, {true, 0.0f, restInSeconds});
+      }
+      return wake;
+   }
+
+   void CameraBatch::RebuildActiveList() {
+      m_active.clear();
+      for (size_t i = 0; i < Size(); ++i) {
+         if (m_awake[i]) {
+            m_active.push_back(uint32_t(i));
+         }
+      }
+   }
+
+   void CameraBatch::CalculateViewMatrices(size_t begin, size_t end) {
+      assert(begin <= end && end <= Size());
+
+      if (begin == end) {
+         return;
+      }
+      peasycamera::CalculateViewMatrices(m_state.data() + begin, end - begin, m_viewMatrix[begin].m_elements);
+   }
+
+   void CameraBatch::UpdateActive(std::span<const IndexedInput> inputs, float deltaTimeInSeconds) {
+      for (const IndexedInput& entry : inputs) {
+         const uint32_t i = entry.index;
+         assert(i < Size());
+
+         if (m_settleThresholdInPixels[i] > 0.0f) {
+            UpdateRestThresholds(*this, i, entry.input.viewport);
+         }
+
+         const bool impulse = AddInputImpulses(entry.input, m_dragConstraint[i], m_permaConstraint[i], m_wheelZoomScale[i], m_state[i].m_distance, m_rotateScaleDistance[i], m_rotateScale[i], m_zoom.m_velocity[i], m_panX.m_velocity[i], m_panY.m_velocity[i], m_rotateX.m_velocity[i], m_rotateY.m_velocity[i], m_rotateZ.m_velocity[i]);
+         if (impulse) {
+            Wake(i);
+         }
+      }
+
+      for (uint32_t i : m_active) {
+         m_lastDeltaTimeInSeconds[i] = deltaTimeInSeconds;
+         m_stepStartState[i] = m_state[i];
+      }
+
+      for (uint32_t i : m_active) {
+         DampedAction zoom = Load(m_zoom, i);
+         ApplyZoom(zoom, deltaTimeInSeconds, m_state[i].m_distance, m_minDistance[i], m_maxDistance[i]);
+         StoreMotion(m_zoom, i, zoom);
+      }
+
+      for (uint32_t i : m_active) {
+         DampedAction panX = Load(m_panX, i);
+         DampedAction panY = Load(m_panY, i);
+         ApplyPan(panX, panY, deltaTimeInSeconds, m_dragConstraint[i], m_state[i]);
+         StoreMotion(m_panX, i, panX);
+         StoreMotion(m_panY, i, panY);
+      }
+
+      for (uint32_t i : m_active) {
+         DampedAction rotateX = Load(m_rotateX, i);
+         DampedAction rotateY = Load(m_rotateY, i);
+         DampedAction rotateZ = Load(m_rotateZ, i);
+
+         m_state[i].m_rotation = ApplyRotate(rotateX, rotateY, rotateZ, deltaTimeInSeconds, m_state[i].m_rotation);
+
+         StoreMotion(m_rotateX, i, rotateX);
+         StoreMotion(m_rotateY, i, rotateY);
+         StoreMotion(m_rotateZ, i, rotateZ);
+      }
+
+      for (uint32_t i : m_active) {
+         if (InterpolationActive(m_distanceInterpolator, i)) {
+            m_state[i].m_distance = Clamp(UpdateInterpolation(m_distanceInterpolator, i, deltaTimeInSeconds), m_minDistance[i], m_maxDistance[i]);
+         }
+
+         if (InterpolationActive(m_lookAtInterpolator, i)) {
+            m_state[i].m_lookAt = UpdateInterpolation(m_lookAtInterpolator, i, deltaTimeInSeconds);
+         }
+
+         if (InterpolationActive(m_rotationInterpolator, i)) {
+            m_state[i].m_rotation = UpdateInterpolation(m_rotationInterpolator, i, deltaTimeInSeconds);
+         }
+      }
+
+      size_t kept = 0;
+      for (uint32_t i : m_active) {
+         if (!Equal(m_stepStartState[i], m_state[i])) {
+            ++m_epoch[i];
+         }
+
+         if (Settled(*this, i)) {
+            m_awake[i] = 0;
+         } else {
+            m_active[kept++] = i;
+         }
+      }
+      m_active.resize(kept);
+   }
+
+   void CameraBatch::Wake(size_t index) {
+      assert(index < Size());
+
+      if (!m_awake[index]) {
+         m_awake[index] = 1;
+         m_active.push_back(uint32_t(index));
+      }
+   }
+
+   void CameraBatch::SetState(size_t index, const CameraState& state, float animationTimeInSeconds) {
+      assert(index < Size());
+
+      if (animationTimeInSeconds <= 0.0f) {
+         m_state[index] = state;
+         ++m_epoch[index];
+      } else {
+         StartInterpolation(m_rotationInterpolator, index, m_state[index].m_rotation, state.m_rotation, animationTimeInSeconds);
+         StartInterpolation(m_lookAtInterpolator, index, m_state[index].m_lookAt, state.m_lookAt, animationTimeInSeconds);
+         StartInterpolation(m_distanceInterpolator, index, m_state[index].m_distance, state.m_distance, animationTimeInSeconds);
+         Wake(index);
+      }
+   }
 }
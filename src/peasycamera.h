@@ -1,5 +1,11 @@
 #pragma once
 
+#include <stddef.h>
+#include <stdint.h>
+#include <new>
+#include <span>
+#include <vector>
+
 namespace peasycamera {
 
    struct vec3 { float x, y, z; };
@@ -8,9 +14,40 @@ namespace peasycamera {
    constexpr quat kIdentityRotation = {0.0f, 0.0f, 0.0f, 1.0f};
    constexpr float kDefaultFriction = 0.16f;
 
+   // Updates per second that m_friction is tuned for in DampingMode::TimeBased.
+   constexpr float kDampingReferenceRate = 60.0f;
+
+   // Most Update time Camera::SetFixedTimeStep simulates per Update, the rest of a longer frame is
+   // dropped so a stall does not snowball.
+   constexpr float kMaxFixedStepCatchUp = 0.25f;
+
+   // Seconds a Spring action takes to come to rest after its last impulse.
+   constexpr float kDefaultSettleTime = 0.4f;
+
+   // PerUpdate applies m_friction once per Update whatever the frame time, so the feel depends on
+   // the frame rate. TimeBased applies it kDampingReferenceRate times per second of
+   // Input::deltaTimeInSeconds in closed form, so the cost of an Update does not depend on dt.
+   // Spring moves toward the point the other modes would glide to with a critically damped
+   // spring, exact for any dt, and comes to rest exactly m_settleTimeInSeconds after the last
+   // impulse.
+   enum class DampingMode { PerUpdate, TimeBased, Spring };
+
    struct DampedAction {
       float m_velocity = 0.0f;
       float m_friction = kDefaultFriction;
+      DampingMode m_mode = DampingMode::PerUpdate;
+
+      // Spring only. Impulses still land in m_velocity; the next step moves them into
+      // m_springOffset, the distance left to travel.
+      float m_settleTimeInSeconds = kDefaultSettleTime;
+      float m_springOffset = 0.0f;
+      float m_springRate = 0.0f;
+      float m_settleTimeLeft = 0.0f;
+
+      // Motion left to cover, in the units of m_velocity, that is too small to see. The action
+      // rests once what it still has to glide is below it, see Camera::SetSettleThreshold. 0 uses
+      // the fixed velocity cutoff, and the full settle time for Spring.
+      float m_restThreshold = 0.0f;
    };
 
    enum class Constraint { None, Yaw, Pitch, Roll, SuppressRoll };
@@ -21,6 +58,27 @@ namespace peasycamera {
       float m_distance;
    };
 
+   // When a camera needs its next Update without new input. While m_moving is false nothing
+   // changes until the next input, so a host loop can block on it. Otherwise the first Update that
+   // changes the state is due in m_nextChangeInSeconds and the last one in m_restInSeconds.
+   struct WakeTime {
+      bool m_moving = false;
+      float m_nextChangeInSeconds = 0.0f;
+      float m_restInSeconds = 0.0f;
+   };
+
+   // How fast the camera moves as of the last Update, per second, from the damped velocities and
+   // the running interpolations. The angular velocity is about the camera axes like the rotate
+   // actions, the look-at velocity is in world units and the zoom rate is the relative change of
+   // the distance, positive when moving away. The screen speed is a rough upper bound on how
+   // fast points at the look-at depth move across the viewport, in pixels.
+   struct MotionSignals {
+      vec3 m_angularVelocity = { };
+      vec3 m_lookAtVelocity = { };
+      float m_zoomRate = 0.0f;
+      float m_screenSpeedInPixels = 0.0f;
+   };
+
    template <typename T>
    struct Interpolator {
       float timeInSeconds = 0.0f;
@@ -44,6 +102,22 @@ namespace peasycamera {
       bool shiftKeyDown;
    };
 
+   // A single mouse event for the event stream overload of Camera::Update. Positions and deltas
+   // are in unrounded pixels; timeInSeconds is the time since the previous Update.
+   struct InputEvent {
+      float timeInSeconds;
+      float mouseX;
+      float mouseY;
+      float mouseDX;
+      float mouseDY;
+      float mouseWheelDelta;
+
+      bool leftMouseButtonDown;
+      bool middleMouseButtonDown;
+      bool rightMouseButtonDown;
+      bool shiftKeyDown;
+   };
+
    struct Camera {
       Interpolator<float> m_distanceInterpolator;
       Interpolator<vec3> m_lookAtInterpolator;
@@ -60,6 +134,10 @@ namespace peasycamera {
       float m_maxDistance = 500.0f;
       float m_wheelZoomScale = 1.0f;
 
+      // Rotate drag scale for m_rotateScaleDistance, recalculated when the distance changes.
+      float m_rotateScaleDistance = -1.0f;
+      float m_rotateScale = 0.0f;
+
       CameraState m_state;
       CameraState m_resetState;
 
@@ -68,11 +146,83 @@ namespace peasycamera {
 
       float m_viewMatrix[16];
 
+      // m_viewMatrix as of the previous frame, and previous * inverse(current), which takes view
+      // space positions of this frame to where they were in the previous one. For clip space wrap
+      // it in the projection: projection * m_reprojectionMatrix * inverse(projection). Each Update
+      // starts a frame, see CalculateViewMatrix.
+      float m_previousViewMatrix[16];
+      float m_reprojectionMatrix[16];
+
+      // Bumped whenever m_state changes: by the immediate Set*, Rotate* and Pan calls and by
+      // Update when it moves the camera. Code that writes m_state directly has to bump it too.
+      uint64_t m_epoch = 1;
+      uint64_t m_viewMatrixEpoch = 0;
+
+      // Counts the Update calls; m_viewMatrixUpdateCount is the count m_viewMatrix was last built
+      // or rolled over at.
+      uint64_t m_updateCount = 0;
+      uint64_t m_viewMatrixUpdateCount = 0;
+
+      // Set by Update once every velocity is zero and no interpolation is running. A sleeping
+      // camera skips all work in Update until an input impulse or an animated Set* wakes it.
+      // Call Wake after writing velocities or interpolators directly.
+      bool m_asleep = false;
+
+      // Input::deltaTimeInSeconds of the last Update, PredictState uses it to turn seconds into
+      // PerUpdate steps.
+      float m_lastDeltaTimeInSeconds = 0.0f;
+
+      // See SetFixedTimeStep. m_fixedTimeLeft is the time Update received but has not stepped yet,
+      // m_previousState the state one step before m_state. It only belongs to m_state while
+      // m_previousStateEpoch matches m_epoch, immediate Set* calls make it stale.
+      float m_fixedTimeStep = 0.0f;
+      float m_fixedTimeLeft = 0.0f;
+      CameraState m_previousState;
+      uint64_t m_previousStateEpoch = 0;
+
+      // See SetSettleThreshold, 0 pixels when off.
+      float m_settleThresholdInPixels = 0.0f;
+      float m_tanHalfVerticalFov = 0.0f;
+
+      // Called by Update(const Input&) with every input before it is applied, see SessionRecorder.
+      void (*m_inputHook)(void* context, const Camera& camera, const Input& input) = nullptr;
+      void* m_inputHookContext = nullptr;
+
       Camera(float distance, float lookAtX = 0.0f, float lookAtY = 0.0f, float lookAtZ = 0.0f);
 
+      // Builds m_viewMatrix and m_reprojectionMatrix from GetRenderState(). The first build after
+      // an Update moves the old m_viewMatrix to m_previousViewMatrix, later builds in the same
+      // frame keep it.
       void CalculateViewMatrix();
+
+      // m_viewMatrix, recalculated only if the render state changed since it was last built. In a
+      // frame where it did not change, the previous matrix catches up with the current one and the
+      // reprojection becomes the identity.
+      const float* GetViewMatrix();
+      uint64_t GetEpoch() const { return m_epoch; }
+
+      bool IsAsleep() const { return m_asleep; }
+      void Wake() { m_asleep = false; }
       void Update(const Input& input);
 
+      // Update from the raw events received since the previous Update, sorted by time. TimeBased
+      // actions are integrated up to each event before its impulse is added; PerUpdate actions
+      // count Updates rather than time, so they take the sum of the impulses and one step. The axis
+      // of a shift drag is picked from the summed motion of the shift-held events, not per event.
+      // m_inputHook is not called, so a SessionRecorder does not record these updates.
+      void Update(std::span<const InputEvent> events, const int viewport[4], float deltaTimeInSeconds);
+
+      // Steps the actions and interpolators every stepInSeconds of Update time, e.g. 1.0f / 240.0f,
+      // instead of once per Update, and carries the remainder over to the next Update. Behavior
+      // then no longer depends on the Update rate; PerUpdate actions damp once per step. At most
+      // kMaxFixedStepCatchUp seconds are stepped per Update. 0 turns it off.
+      void SetFixedTimeStep(float stepInSeconds);
+
+      // The state to draw secondsSinceUpdate after the last Update. With a fixed time step this is
+      // the blend of the last two steps at that time, which runs up to one step behind m_state;
+      // otherwise it is m_state.
+      CameraState GetRenderState(float secondsSinceUpdate = 0.0f) const;
+
       void Pan(float dx, float dy);
 
       float GetDistance() const { return m_state.m_distance; }
@@ -91,8 +241,37 @@ namespace peasycamera {
       CameraState GetState() const { return m_state; }
       void SetState(const CameraState& state, float animationTimeInSeconds = 0.0f);
 
+      // The state Update would reach secondsAhead from now if no further input arrives, without
+      // touching the camera. PerUpdate actions are assumed to keep getting one Update every
+      // m_lastDeltaTimeInSeconds and are stepped like that until they rest, TimeBased and Spring
+      // actions are evaluated in closed form for the rest of the time.
+      CameraState PredictState(float secondsAhead) const;
+
       void Reset(float animationTimeInSeconds = 0.0f);
 
+      void SetDampingMode(DampingMode mode);
+      // Used by the actions in DampingMode::Spring.
+      void SetSettleTime(float settleTimeInSeconds);
+
+      // Time until every action has come to rest, 0 if none is moving. Exact for Spring actions;
+      // PerUpdate actions are assumed to keep getting m_lastDeltaTimeInSeconds per Update.
+      // Interpolations started by Set* are not included.
+      float GetSettleTimeInSeconds() const;
+
+      // Lets every action come to rest as soon as the screen motion it has left is below pixels,
+      // instead of at the fixed velocity cutoff. Update works the motion out at the look-at depth
+      // from the Input viewport and verticalFovInRadians, the field of view of the projection the
+      // camera is drawn with. 0 pixels turns it off.
+      void SetSettleThreshold(float pixels, float verticalFovInRadians);
+
+      // Covers the actions like GetSettleTimeInSeconds and the interpolations. Updates are due
+      // right away while anything moves, or at the next step with a fixed time step.
+      WakeTime GetWakeTime() const;
+
+      // viewport and verticalFovInRadians are those the camera is drawn with, they only scale
+      // MotionSignals::m_screenSpeedInPixels. All zero while asleep.
+      MotionSignals GetMotionSignals(const int viewport[4], float verticalFovInRadians) const;
+
       void SetFreeRotationMode();
       void SetYawRotationMode();
       void SetPitchRotationMode();
@@ -109,4 +288,158 @@ namespace peasycamera {
       // @TODO: Custom impulse providers
    };
 
+
+   // Writes 16 floats per camera to outViewMatrices, same layout as Camera::m_viewMatrix.
+   // Uses AVX2 (8 cameras at a time) or SSE2 (4 at a time) when the compiler targets them,
+   // define PEASYCAMERA_NO_SIMD to force the scalar path.
+   void CalculateViewMatrices(const CameraState* states, size_t count, float* outViewMatrices);
+
+   // Approximate slerp of count rotation pairs stored as structure of arrays: a[0..3] point at the
+   // x, y, z and w components of the start rotations, b at the end rotations and out at the
+   // results, t[i] is the blend of pair i. Uses the constant time polynomial the interpolators
+   // switch to with PEASYCAMERA_FAST_MATH, 8 (AVX2) or 4 (SSE2) pairs at a time. The results are
+   // unit length and within 1.7e-5 radians of the exact slerp, 3.5e-7 up to 90 degrees apart.
+   void SLerpRotations(const float* const a[4], const float* const b[4], const float* t, size_t count, float* const out[4]);
+
+   // The wake time of two cameras together: the earlier next change and the later rest.
+   WakeTime MergeWakeTimes(const WakeTime& a, const WakeTime& b);
+
+   constexpr size_t kCacheLineSize = 64;
+
+   // Starts every allocation on its own cache line, see CameraBatch.
+   template <typename T>
+   struct CacheLineAllocator {
+      using value_type = T;
+
+      CacheLineAllocator() = default;
+      template <typename U> CacheLineAllocator(const CacheLineAllocator<U>&) { }
+
+      T* allocate(size_t count) { return static_cast<T*>(::operator new(count * sizeof(T), std::align_val_t(kCacheLineSize))); }
+      void deallocate(T* pointer, size_t) { ::operator delete(pointer, std::align_val_t(kCacheLineSize)); }
+
+      template <typename U> bool operator ==(const CacheLineAllocator<U>&) const { return true; }
+   };
+
+   // Structure-of-arrays storage for updating many cameras at once. Every camera field
+   // that Camera::Update touches lives in its own contiguous array and UpdateAll runs
+   // one stage at a time over all cameras. Results are bit-identical to calling
+   // Camera::Update on each camera.
+   //
+   // Arrays start on a cache line and each view matrix fills exactly one line, so ranges that
+   // begin at a multiple of kBatchRangeAlignment cameras never share a line with each other.
+   // That lets threads update neighbouring ranges without false sharing.
+   struct CameraBatch {
+      template <typename T>
+      using Array = std::vector<T, CacheLineAllocator<T>>;
+
+      struct alignas(kCacheLineSize) ViewMatrix {
+         float m_elements[16];
+      };
+
+      struct DampedActionArray {
+         Array<float> m_velocity;
+         Array<float> m_friction;
+         Array<DampingMode> m_mode;
+         Array<float> m_settleTimeInSeconds;
+         Array<float> m_springOffset;
+         Array<float> m_springRate;
+         Array<float> m_settleTimeLeft;
+         Array<float> m_restThreshold;
+      };
+
+      template <typename T>
+      struct InterpolatorArray {
+         Array<float> timeInSeconds;
+         Array<float> timeConsumedInSeconds;
+         Array<T> startValue;
+         Array<T> endValue;
+      };
+
+      static constexpr size_t kBatchRangeAlignment = kCacheLineSize;
+
+      Array<CameraState> m_state;
+      Array<CameraState> m_resetState;
+      Array<ViewMatrix> m_viewMatrix;
+
+      DampedActionArray m_panX;
+      DampedActionArray m_panY;
+      DampedActionArray m_zoom;
+      DampedActionArray m_rotateX;
+      DampedActionArray m_rotateY;
+      DampedActionArray m_rotateZ;
+
+      InterpolatorArray<float> m_distanceInterpolator;
+      InterpolatorArray<vec3> m_lookAtInterpolator;
+      InterpolatorArray<quat> m_rotationInterpolator;
+
+      Array<float> m_minDistance;
+      Array<float> m_maxDistance;
+      Array<float> m_wheelZoomScale;
+      Array<float> m_rotateScaleDistance;
+      Array<float> m_rotateScale;
+
+      // See Camera::SetSettleThreshold; the rest thresholds follow the viewport of each input.
+      Array<float> m_settleThresholdInPixels;
+      Array<float> m_tanHalfVerticalFov;
+      Array<float> m_lastDeltaTimeInSeconds;
+
+      // Camera::m_epoch, bumped by every update that changes m_state and by SetState.
+      // m_stepStartState is m_state before the running update, which the bump compares against.
+      Array<uint64_t> m_epoch;
+      Array<CameraState> m_stepStartState;
+
+      Array<Constraint> m_dragConstraint;
+      Array<Constraint> m_permaConstraint;
+
+      // Indices of the cameras that are awake, in no particular order. m_awake[i] says whether
+      // camera i is in the list.
+      std::vector<uint32_t> m_active;
+      Array<uint8_t> m_awake;
+
+      struct IndexedInput {
+         uint32_t index;
+         Input input;
+      };
+
+      // Cameras with a fixed time step are not supported, the batch steps once per update.
+      size_t Add(const Camera& camera);
+      void Remove(size_t index);
+      void Clear();
+      size_t Size() const { return m_state.size(); }
+
+      Camera GetCamera(size_t index) const;
+      void SetCamera(size_t index, const Camera& camera);
+
+      // inputs[i] is the input for camera i, inputs.size() must equal Size().
+      void UpdateAll(std::span<const Input> inputs);
+
+      // UpdateAll for the cameras in [begin, end) only. Ranges touch disjoint data, so they can
+      // run on different threads; RebuildActiveList has to run once they are all done.
+      void UpdateRange(std::span<const Input> inputs, size_t begin, size_t end);
+      void RebuildActiveList();
+
+      // Fills m_viewMatrix from m_state, see peasycamera::CalculateViewMatrices.
+      void CalculateViewMatrices() { CalculateViewMatrices(0, Size()); }
+      void CalculateViewMatrices(size_t begin, size_t end);
+
+      // Steps only the awake cameras, so the cost scales with the active list instead of Size().
+      // inputs holds the cameras that received input this tick; the ones it wakes join the
+      // active list. deltaTimeInSeconds is used for every camera and the deltaTimeInSeconds of
+      // the inputs is ignored. Cameras without an entry are stepped as if they had no input but
+      // keep their drag constraint and the rest thresholds of their last viewport. Cameras that
+      // settle drop out of the active list.
+      void UpdateActive(std::span<const IndexedInput> inputs, float deltaTimeInSeconds);
+
+      bool IsAsleep(size_t index) const { return m_awake[index] == 0; }
+      void Wake(size_t index);
+      size_t ActiveCount() const { return m_active.size(); }
+
+      // Camera::GetWakeTime merged over the active list, which has to be current. PerUpdate actions
+      // are assumed to get one Update every frameTimeInSeconds.
+      WakeTime GetWakeTime(float frameTimeInSeconds) const;
+
+      CameraState GetState(size_t index) const { return m_state[index]; }
+      void SetState(size_t index, const CameraState& state, float animationTimeInSeconds = 0.0f);
+   };
+
 }
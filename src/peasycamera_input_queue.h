@@ -0,0 +1,90 @@
+#pragma once
+
+#include "peasycamera.h"
+
+#include <atomic>
+#include <chrono>
+#include <span>
+
+namespace peasycamera {
+
+   // Bounded single-producer single-consumer queue of input events, so raw input can be sampled
+   // on its own thread at the device rate while the update thread drains it once per frame.
+   // Lock-free and allocation-free. Every event is stored twice, Capacity slots apart, which
+   // keeps the unread events one contiguous span that can go straight to Camera::Update.
+   template <size_t Capacity>
+   struct InputEventQueue {
+      static_assert(Capacity > 0 && (Capacity & (Capacity - 1)) == 0, "Capacity must be a power of two");
+
+      using Clock = std::chrono::steady_clock;
+      static constexpr size_t kMask = Capacity - 1;
+
+      InputEvent m_events[2 * Capacity];
+      Clock::time_point m_times[Capacity];
+
+      // Written by the producer, read by the consumer.
+      alignas(kCacheLineSize) std::atomic<size_t> m_head {0};
+      // Written by the consumer, read by the producer.
+      alignas(kCacheLineSize) std::atomic<size_t> m_tail {0};
+
+      // Owned by the producer.
+      alignas(kCacheLineSize) size_t m_producerTail = 0;
+      uint64_t m_droppedEvents = 0;
+
+      // Owned by the consumer.
+      alignas(kCacheLineSize) Clock::time_point m_lastConsumeTime = Clock::now();
+
+      // Producer. Returns false, dropping the event, if the queue is full. event.timeInSeconds is
+      // ignored, the consumer derives it from time.
+      bool Push(const InputEvent& event, Clock::time_point time = Clock::now()) {
+         const size_t head = m_head.load(std::memory_order_relaxed);
+
+         if (head - m_producerTail == Capacity) {
+            m_producerTail = m_tail.load(std::memory_order_acquire);
+            if (head - m_producerTail == Capacity) {
+               ++m_droppedEvents;
+               return false;
+            }
+         }
+
+         const size_t slot = head & kMask;
+         m_events[slot] = event;
+         m_events[slot + Capacity] = event;
+         m_times[slot] = time;
+
+         m_head.store(head + 1, std::memory_order_release);
+         return true;
+      }
+
+      // Consumer. Calls function(std::span<InputEvent> events, float deltaTimeInSeconds) once with
+      // the events pushed up to time, their timeInSeconds rewritten relative to the previous
+      // Consume, and deltaTimeInSeconds the time since then. Later events stay queued.
+      template <typename Function>
+      size_t Consume(Clock::time_point time, Function&& function) {
+         const size_t tail = m_tail.load(std::memory_order_relaxed);
+         const size_t head = m_head.load(std::memory_order_acquire);
+
+         const size_t first = tail & kMask;
+         size_t count = 0;
+         for (; tail + count != head && m_times[(tail + count) & kMask] <= time; ++count) {
+            const float eventTime = std::chrono::duration<float>(m_times[(tail + count) & kMask] - m_lastConsumeTime).count();
+            m_events[first + count].timeInSeconds = eventTime > 0.0f ? eventTime : 0.0f;
+         }
+
+         function(std::span<InputEvent>(m_events + first, count), std::chrono::duration<float>(time - m_lastConsumeTime).count());
+
+         m_lastConsumeTime = time;
+         m_tail.store(tail + count, std::memory_order_release);
+         return count;
+      }
+   };
+
+   // Camera::Update with every event the input thread queued since the previous call.
+   template <size_t Capacity>
+   size_t Update(Camera& camera, InputEventQueue<Capacity>& queue, const int viewport[4], typename InputEventQueue<Capacity>::Clock::time_point time = InputEventQueue<Capacity>::Clock::now()) {
+      return queue.Consume(time, [&](std::span<InputEvent> events, float deltaTimeInSeconds) {
+         camera.Update(events, viewport, deltaTimeInSeconds);
+      });
+   }
+
+}
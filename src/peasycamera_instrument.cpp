@@ -0,0 +1,121 @@
+#include "peasycamera_instrument.h"
+
+#if PEASYCAMERA_INSTRUMENT
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <vector>
+
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#include <intrin.h>
+#define PEASYCAMERA_RDTSC 1
+#elif (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+#include <x86intrin.h>
+#define PEASYCAMERA_RDTSC 1
+#endif
+#endif
+
+namespace peasycamera {
+
+#if PEASYCAMERA_INSTRUMENT
+   namespace {
+      constexpr size_t kStageCount = size_t(Stage::Count);
+
+      // Only the owning thread writes its counters, so plain load + store is enough; the
+      // atomics only keep snapshots from other threads well defined.
+      struct ThreadCounters {
+         std::atomic<uint64_t> m_calls[kStageCount] = { };
+         std::atomic<uint64_t> m_ticks[kStageCount] = { };
+
+         ThreadCounters();
+         ~ThreadCounters();
+      };
+
+      struct Registry {
+         std::mutex m_mutex;
+         std::vector<ThreadCounters*> m_threads;
+         StageCounters m_exitedThreads[kStageCount];
+
+         std::chrono::steady_clock::time_point m_startTime = std::chrono::steady_clock::now();
+         uint64_t m_startTicks = instrument::ReadTicks();
+      };
+
+      Registry& GetRegistry() {
+         static Registry registry;
+         return registry;
+      }
+
+      ThreadCounters::ThreadCounters() {
+         Registry& registry = GetRegistry();
+         std::lock_guard<std::mutex> lock(registry.m_mutex);
+         registry.m_threads.push_back(this);
+      }
+
+      // Keeps the totals of threads that have finished.
+      ThreadCounters::~ThreadCounters() {
+         Registry& registry = GetRegistry();
+         std::lock_guard<std::mutex> lock(registry.m_mutex);
+
+         for (size_t i = 0; i < kStageCount; ++i) {
+            registry.m_exitedThreads[i].m_calls += m_calls[i].load(std::memory_order_relaxed);
+            registry.m_exitedThreads[i].m_ticks += m_ticks[i].load(std::memory_order_relaxed);
+         }
+
+         for (size_t i = 0; i < registry.m_threads.size(); ++i) {
+            if (registry.m_threads[i] == this) {
+               registry.m_threads[i] = registry.m_threads.back();
+               registry.m_threads.pop_back();
+               break;
+            }
+         }
+      }
+
+      thread_local ThreadCounters t_counters;
+   }
+
+   namespace instrument {
+      uint64_t ReadTicks() {
+#if PEASYCAMERA_RDTSC
+         return __rdtsc();
+#else
+         return uint64_t(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count());
+#endif
+      }
+
+      void Record(Stage stage, uint64_t ticks) {
+         const size_t i = size_t(stage);
+         t_counters.m_calls[i].store(t_counters.m_calls[i].load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+         t_counters.m_ticks[i].store(t_counters.m_ticks[i].load(std::memory_order_relaxed) + ticks, std::memory_order_relaxed);
+      }
+   }
+#endif
+
+   const char* GetStageName(Stage stage) {
+      static const char* const names[] = {"impulses", "zoom", "pan", "rotate", "distance_interpolator", "look_at_interpolator", "rotation_interpolator", "view_matrix"};
+      static_assert(sizeof(names) / sizeof(names[0]) == size_t(Stage::Count), "one name per stage");
+      return stage < Stage::Count ? names[size_t(stage)] : "unknown";
+   }
+
+   InstrumentationSnapshot GetInstrumentationSnapshot() {
+      InstrumentationSnapshot snapshot;
+
+#if PEASYCAMERA_INSTRUMENT
+      Registry& registry = GetRegistry();
+      std::lock_guard<std::mutex> lock(registry.m_mutex);
+
+      for (size_t i = 0; i < kStageCount; ++i) {
+         snapshot.m_stages[i] = registry.m_exitedThreads[i];
+         for (const ThreadCounters* counters : registry.m_threads) {
+            snapshot.m_stages[i].m_calls += counters->m_calls[i].load(std::memory_order_relaxed);
+            snapshot.m_stages[i].m_ticks += counters->m_ticks[i].load(std::memory_order_relaxed);
+         }
+      }
+
+      const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - registry.m_startTime).count();
+      snapshot.m_ticksPerSecond = seconds > 0.0 ? double(instrument::ReadTicks() - registry.m_startTicks) / seconds : 0.0;
+#endif
+
+      return snapshot;
+   }
+
+}
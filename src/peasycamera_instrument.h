@@ -0,0 +1,50 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Build with PEASYCAMERA_INSTRUMENT=1 to count and time the stages of Camera::Update and
+// CalculateViewMatrix. Without it the scopes compile to nothing and snapshots stay zero.
+#ifndef PEASYCAMERA_INSTRUMENT
+   #define PEASYCAMERA_INSTRUMENT 0
+#endif
+
+namespace peasycamera {
+
+   enum class Stage : uint32_t { Impulses, Zoom, Pan, Rotate, DistanceInterpolator, LookAtInterpolator, RotationInterpolator, ViewMatrix, Count };
+
+   struct StageCounters {
+      uint64_t m_calls = 0;
+      uint64_t m_ticks = 0;
+   };
+
+   // Totals over every thread since startup. Subtract two snapshots to look at an interval.
+   struct InstrumentationSnapshot {
+      StageCounters m_stages[size_t(Stage::Count)];
+      double m_ticksPerSecond = 0.0;
+   };
+
+   const char* GetStageName(Stage stage);
+   InstrumentationSnapshot GetInstrumentationSnapshot();
+
+#if PEASYCAMERA_INSTRUMENT
+   namespace instrument {
+      uint64_t ReadTicks();
+      void Record(Stage stage, uint64_t ticks);
+
+      struct ScopedTimer {
+         Stage m_stage;
+         uint64_t m_start;
+
+         explicit ScopedTimer(Stage stage) : m_stage(stage), m_start(ReadTicks()) { }
+         ~ScopedTimer() { Record(m_stage, ReadTicks() - m_start); }
+      };
+   }
+
+   // Times the rest of the enclosing block as stage.
+   #define PEASYCAMERA_INSTRUMENT_SCOPE(stage) const ::peasycamera::instrument::ScopedTimer peasycameraInstrumentTimer(stage)
+#else
+   #define PEASYCAMERA_INSTRUMENT_SCOPE(stage) ((void)0)
+#endif
+
+}
@@ -0,0 +1,162 @@
+#include "peasycamera_parallel.h"
+#include <assert.h>
+
+namespace peasycamera {
+   namespace {
+      uint64_t PackRange(uint64_t begin, uint64_t end) { return (end << 32) | begin; }
+      uint64_t RangeBegin(uint64_t range) { return range & 0xffffffffu; }
+      uint64_t RangeEnd(uint64_t range) { return range >> 32; }
+
+      bool PopFront(ThreadPool::WorkQueue& queue, size_t& outIndex) {
+         uint64_t range = queue.m_range.load(std::memory_order_relaxed);
+         while (RangeBegin(range) < RangeEnd(range)) {
+            if (queue.m_range.compare_exchange_weak(range, PackRange(RangeBegin(range) + 1, RangeEnd(range)), std::memory_order_acquire, std::memory_order_relaxed)) {
+               outIndex = size_t(RangeBegin(range));
+               return true;
+            }
+         }
+         return false;
+      }
+
+      // Takes the upper half of the victim's remaining range.
+      bool StealBack(ThreadPool::WorkQueue& victim, uint64_t& outRange) {
+         uint64_t range = victim.m_range.load(std::memory_order_relaxed);
+         while (RangeBegin(range) < RangeEnd(range)) {
+            const uint64_t begin = RangeBegin(range);
+            const uint64_t end = RangeEnd(range);
+            const uint64_t middle = begin + (end - begin) / 2;
+
+            if (victim.m_range.compare_exchange_weak(range, PackRange(begin, middle), std::memory_order_acquire, std::memory_order_relaxed)) {
+               outRange = PackRange(middle, end);
+               return true;
+            }
+         }
+         return false;
+      }
+   }
+
+   ThreadPool::ThreadPool(unsigned threadCount) {
+      threadCount = threadCount > 0 ? threadCount : 1;
+
+      m_queues = std::make_unique<WorkQueue[]>(threadCount);
+      for (unsigned i = 1; i < threadCount; ++i) {
+         m_threads.emplace_back([this, i]() { WorkerLoop(i); });
+      }
+   }
+
+   ThreadPool::~ThreadPool() {
+      {
+         std::lock_guard<std::mutex> lock(m_mutex);
+         m_stop = true;
+      }
+      m_wake.notify_all();
+
+      for (std::thread& thread : m_threads) {
+         thread.join();
+      }
+   }
+
+   void ThreadPool::Run(size_t count, void (*task)(void* context, size_t index), void* context) {
+      assert(uint64_t(count) <= 0xffffffffu);
+
+      const unsigned threadCount = GetThreadCount();
+
+      {
+         std::lock_guard<std::mutex> lock(m_mutex);
+         m_task = task;
+         m_context = context;
+
+         for (unsigned i = 0; i < threadCount; ++i) {
+            const uint64_t begin = uint64_t(count) * i / threadCount;
+            const uint64_t end = uint64_t(count) * (i + 1) / threadCount;
+            m_queues[i].m_range.store(PackRange(begin, end), std::memory_order_relaxed);
+         }
+
+         m_busyWorkers = threadCount - 1;
+         ++m_generation;
+      }
+      m_wake.notify_all();
+
+      Execute(0);
+
+      std::unique_lock<std::mutex> lock(m_mutex);
+      m_done.wait(lock, [this]() { return m_busyWorkers == 0; });
+   }
+
+   void ThreadPool::WorkerLoop(unsigned worker) {
+      uint64_t seenGeneration = 0;
+
+      for (;;) {
+         {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_wake.wait(lock, [&]() { return m_stop || m_generation != seenGeneration; });
+
+            if (m_stop) {
+               return;
+            }
+            seenGeneration = m_generation;
+         }
+
+         Execute(worker);
+
+         bool last = false;
+         {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            last = (--m_busyWorkers == 0);
+         }
+
+         if (last) {
+            m_done.notify_one();
+         }
+      }
+   }
+
+   void ThreadPool::Execute(unsigned worker) {
+      const unsigned threadCount = GetThreadCount();
+      WorkQueue& own = m_queues[worker];
+
+      for (;;) {
+         size_t index;
+         if (PopFront(own, index)) {
+            m_task(m_context, index);
+            continue;
+         }
+
+         // Out of work: steal from the other workers, nearest first. The own queue is empty
+         // here, so nobody else can be stealing from it when the stolen range is stored.
+         bool stole = false;
+         for (unsigned i = 1; i < threadCount && !stole; ++i) {
+            uint64_t range;
+            if (StealBack(m_queues[(worker + i) % threadCount], range)) {
+               own.m_range.store(range, std::memory_order_relaxed);
+               stole = true;
+            }
+         }
+
+         if (!stole) {
+            return;
+         }
+      }
+   }
+
+   void UpdateAll(ThreadPool& pool, CameraBatch& batch, std::span<const Input> inputs, size_t chunkSize) {
+      assert(inputs.size() == batch.Size());
+
+      constexpr size_t alignment = CameraBatch::kBatchRangeAlignment;
+      chunkSize = (chunkSize + alignment - 1) / alignment * alignment;
+      chunkSize = chunkSize > 0 ? chunkSize : alignment;
+
+      const size_t count = batch.Size();
+      const size_t chunkCount = (count + chunkSize - 1) / chunkSize;
+
+      pool.ParallelFor(chunkCount, [&](size_t chunk) {
+         const size_t begin = chunk * chunkSize;
+         const size_t end = begin + chunkSize < count ? begin + chunkSize : count;
+
+         batch.UpdateRange(inputs, begin, end);
+         batch.CalculateViewMatrices(begin, end);
+      });
+
+      batch.RebuildActiveList();
+   }
+}
@@ -0,0 +1,64 @@
+#pragma once
+
+#include "peasycamera.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+
+namespace peasycamera {
+
+   // Fixed set of worker threads running index ranges with work stealing. Run splits
+   // [0, count) evenly between the workers and the calling thread; a worker that runs out
+   // of indices steals the upper half of the remaining range of the next busy worker.
+   struct ThreadPool {
+      struct alignas(kCacheLineSize) WorkQueue {
+         // Remaining range packed as (end << 32) | begin so owner and thieves agree with one CAS.
+         std::atomic<uint64_t> m_range {0};
+      };
+
+      std::vector<std::thread> m_threads;
+      std::unique_ptr<WorkQueue[]> m_queues;
+
+      std::mutex m_mutex;
+      std::condition_variable m_wake;
+      std::condition_variable m_done;
+      uint64_t m_generation = 0;
+      unsigned m_busyWorkers = 0;
+      bool m_stop = false;
+
+      void (*m_task)(void* context, size_t index) = nullptr;
+      void* m_context = nullptr;
+
+      // threadCount includes the thread that calls Run.
+      explicit ThreadPool(unsigned threadCount = std::thread::hardware_concurrency());
+      ~ThreadPool();
+
+      ThreadPool(const ThreadPool&) = delete;
+      ThreadPool& operator =(const ThreadPool&) = delete;
+
+      unsigned GetThreadCount() const { return unsigned(m_threads.size()) + 1; }
+
+      // Calls task(context, i) once for every i in [0, count) and returns when all calls are done.
+      void Run(size_t count, void (*task)(void* context, size_t index), void* context);
+
+      template <typename Function>
+      void ParallelFor(size_t count, Function&& function) {
+         using FunctionType = std::remove_reference_t<Function>;
+         Run(count, [](void* context, size_t index) { (*static_cast<FunctionType*>(context))(index); }, &function);
+      }
+
+      void WorkerLoop(unsigned worker);
+      void Execute(unsigned worker);
+   };
+
+   // Multi-threaded CameraBatch::UpdateAll followed by CameraBatch::CalculateViewMatrices.
+   // Cameras are processed in chunks of chunkSize (rounded up to kBatchRangeAlignment) so no
+   // two threads write to the same cache line. Each camera is updated by the same code as the
+   // serial path, so the result does not depend on the thread count.
+   void UpdateAll(ThreadPool& pool, CameraBatch& batch, std::span<const Input> inputs, size_t chunkSize = 1024);
+
+}
@@ -0,0 +1,330 @@
+#include "peasycamera_path.h"
+#include <math.h>
+#include <string.h>
+
+namespace peasycamera {
+   namespace {
+      const uint8_t kPathMagic[4] = {'P', 'C', 'P', 'T'};
+      constexpr uint8_t kPathVersion = 1;
+      constexpr size_t kPathHeaderSize = 14;
+
+      enum : uint8_t {
+         kRotationResidual = 1 << 0,
+         kLookAtResidual = 1 << 1,
+         kDistanceResidual = 1 << 2,
+         kRotationAbsolute = 1 << 3,
+         kLargestComponentShift = 4,
+      };
+
+      constexpr float kSqrtHalf = 0.70710678f;
+
+      // One chunk of quantized frames, one array per value so reconstruction vectorizes.
+      struct QuantizedChunk {
+         int32_t m_rotation[3][PathDecoder::kChunkSize];
+         int32_t m_largestComponent[PathDecoder::kChunkSize];
+         int32_t m_lookAt[3][PathDecoder::kChunkSize];
+         int32_t m_distance[PathDecoder::kChunkSize];
+      };
+
+      void Store(QuantizedChunk& chunk, size_t index, const QuantizedState& state) {
+         for (int i = 0; i < 3; ++i) {
+            chunk.m_rotation[i][index] = state.m_rotation[i];
+            chunk.m_lookAt[i][index] = state.m_lookAt[i];
+         }
+         chunk.m_largestComponent[index] = state.m_largestComponent;
+         chunk.m_distance[index] = state.m_distance;
+      }
+
+      void Dequantize(const QuantizedChunk& chunk, size_t count, uint32_t rotationBits, float lookAtStep, float logDistanceStep, CameraState* outStates) {
+         const float rotationStep = 2.0f * kSqrtHalf / float((1u << rotationBits) - 1);
+
+         for (size_t i = 0; i < count; ++i) {
+            const float c0 = float(chunk.m_rotation[0][i]) * rotationStep - kSqrtHalf;
+            const float c1 = float(chunk.m_rotation[1][i]) * rotationStep - kSqrtHalf;
+            const float c2 = float(chunk.m_rotation[2][i]) * rotationStep - kSqrtHalf;
+            const float rest = 1.0f - (c0 * c0 + c1 * c1 + c2 * c2);
+            const float largest = sqrtf(rest > 0.0f ? rest : 0.0f);
+
+            // The three stored components are the other ones in x, y, z, w order.
+            const int32_t index = chunk.m_largestComponent[i];
+            outStates[i].m_rotation.x = index == 0 ? largest : c0;
+            outStates[i].m_rotation.y = index == 1 ? largest : (index < 1 ? c0 : c1);
+            outStates[i].m_rotation.z = index == 2 ? largest : (index < 2 ? c1 : c2);
+            outStates[i].m_rotation.w = index == 3 ? largest : c2;
+
+            outStates[i].m_lookAt.x = float(chunk.m_lookAt[0][i]) * lookAtStep;
+            outStates[i].m_lookAt.y = float(chunk.m_lookAt[1][i]) * lookAtStep;
+            outStates[i].m_lookAt.z = float(chunk.m_lookAt[2][i]) * lookAtStep;
+         }
+
+         for (size_t i = 0; i < count; ++i) {
+            outStates[i].m_distance = expf(float(chunk.m_distance[i]) * logDistanceStep);
+         }
+      }
+
+      int32_t QuantizeClamped(float value) {
+         const float limit = 1073741824.0f;
+         return int32_t(lrintf(value < -limit ? -limit : (value > limit ? limit : value)));
+      }
+
+      QuantizedState Quantize(const CameraState& state, uint32_t rotationBits, float lookAtStep, float logDistanceStep) {
+         QuantizedState quantized;
+
+         const quat& q = state.m_rotation;
+         const float inv = 1.0f / sqrtf(q.x * q.x + q.y * q.y + q.z * q.z + q.w * q.w);
+         const float components[4] = {q.x * inv, q.y * inv, q.z * inv, q.w * inv};
+
+         int largest = 0;
+         for (int i = 1; i < 4; ++i) {
+            largest = fabsf(components[i]) > fabsf(components[largest]) ? i : largest;
+         }
+
+         // q and -q are the same rotation; flip so the dropped component is positive.
+         const float sign = components[largest] < 0.0f ? -1.0f : 1.0f;
+         const float maxValue = float((1u << rotationBits) - 1);
+         for (int i = 0, j = 0; i < 4; ++i) {
+            if (i != largest) {
+               const float value = (sign * components[i] * kSqrtHalf + 0.5f) * maxValue;
+               quantized.m_rotation[j++] = int32_t(lrintf(value < 0.0f ? 0.0f : (value > maxValue ? maxValue : value)));
+            }
+         }
+         quantized.m_largestComponent = largest;
+
+         quantized.m_lookAt[0] = QuantizeClamped(state.m_lookAt.x / lookAtStep);
+         quantized.m_lookAt[1] = QuantizeClamped(state.m_lookAt.y / lookAtStep);
+         quantized.m_lookAt[2] = QuantizeClamped(state.m_lookAt.z / lookAtStep);
+
+         quantized.m_distance = QuantizeClamped(logf(state.m_distance > 1e-30f ? state.m_distance : 1e-30f) / logDistanceStep);
+         return quantized;
+      }
+
+      // Second-order prediction: the value continues with the difference of the last two frames.
+      int64_t Predict(int32_t previous, int32_t beforePrevious) {
+         return 2 * int64_t(previous) - int64_t(beforePrevious);
+      }
+
+      void WriteVarint(std::vector<uint8_t>& bytes, uint64_t value) {
+         while (value >= 0x80) {
+            bytes.push_back(uint8_t(value | 0x80));
+            value >>= 7;
+         }
+         bytes.push_back(uint8_t(value));
+      }
+
+      void WriteResidual(std::vector<uint8_t>& bytes, int64_t residual) {
+         WriteVarint(bytes, (uint64_t(residual) << 1) ^ uint64_t(residual >> 63));
+      }
+
+      bool ReadVarint(const uint8_t*& data, const uint8_t* end, uint64_t& outValue) {
+         outValue = 0;
+         for (int shift = 0; data < end && shift < 64; shift += 7) {
+            const uint8_t byte = *data++;
+            outValue |= uint64_t(byte & 0x7f) << shift;
+            if (byte < 0x80) {
+               return true;
+            }
+         }
+         return false;
+      }
+
+      bool ReadResidual(const uint8_t*& data, const uint8_t* end, int32_t previous, int32_t beforePrevious, int32_t& outValue) {
+         uint64_t zigzag;
+         if (!ReadVarint(data, end, zigzag)) {
+            return false;
+         }
+         const int64_t residual = int64_t(zigzag >> 1) ^ -int64_t(zigzag & 1);
+         outValue = int32_t(Predict(previous, beforePrevious) + residual);
+         return true;
+      }
+
+      void PushHistory(QuantizedState* history, const QuantizedState& state, bool first) {
+         history[1] = first ? state : history[0];
+         history[0] = state;
+      }
+   }
+
+   PathEncoder::PathEncoder(const PathCodecSettings& settings) {
+      m_rotationBits = settings.m_rotationBits < 2 ? 2 : (settings.m_rotationBits > 16 ? 16 : settings.m_rotationBits);
+      m_lookAtStep = 2.0f * settings.m_lookAtPrecision;
+      m_logDistanceStep = 2.0f * log1pf(settings.m_distancePrecision);
+
+      m_bytes.resize(kPathHeaderSize);
+      memcpy(m_bytes.data(), kPathMagic, 4);
+      m_bytes[4] = kPathVersion;
+      m_bytes[5] = uint8_t(m_rotationBits);
+      memcpy(m_bytes.data() + 6, &m_lookAtStep, 4);
+      memcpy(m_bytes.data() + 10, &m_logDistanceStep, 4);
+   }
+
+   void PathEncoder::Add(const CameraState& state) {
+      const QuantizedState quantized = Quantize(state, m_rotationBits, m_lookAtStep, m_logDistanceStep);
+      const bool first = (m_frameCount == 0);
+      const QuantizedState& previous = m_history[0];
+      const QuantizedState& beforePrevious = m_history[1];
+
+      int64_t rotation[3] = { };
+      int64_t lookAt[3] = { };
+      int64_t distance = 0;
+      const bool absolute = first || quantized.m_largestComponent != previous.m_largestComponent;
+
+      if (!first) {
+         for (int i = 0; i < 3; ++i) {
+            rotation[i] = quantized.m_rotation[i] - Predict(previous.m_rotation[i], beforePrevious.m_rotation[i]);
+            lookAt[i] = quantized.m_lookAt[i] - Predict(previous.m_lookAt[i], beforePrevious.m_lookAt[i]);
+         }
+         distance = quantized.m_distance - Predict(previous.m_distance, beforePrevious.m_distance);
+      }
+
+      uint8_t flags = 0;
+      if (absolute) {
+         flags |= kRotationAbsolute | uint8_t(quantized.m_largestComponent << kLargestComponentShift);
+      } else if (rotation[0] != 0 || rotation[1] != 0 || rotation[2] != 0) {
+         flags |= kRotationResidual;
+      }
+      if (first || lookAt[0] != 0 || lookAt[1] != 0 || lookAt[2] != 0) {
+         flags |= kLookAtResidual;
+      }
+      if (first || distance != 0) {
+         flags |= kDistanceResidual;
+      }
+      m_bytes.push_back(flags);
+
+      if (absolute) {
+         for (int i = 0; i < 3; ++i) {
+            WriteVarint(m_bytes, uint64_t(quantized.m_rotation[i]));
+         }
+      } else if (flags & kRotationResidual) {
+         for (int i = 0; i < 3; ++i) {
+            WriteResidual(m_bytes, rotation[i]);
+         }
+      }
+
+      if (flags & kLookAtResidual) {
+         for (int i = 0; i < 3; ++i) {
+            WriteResidual(m_bytes, first ? quantized.m_lookAt[i] : lookAt[i]);
+         }
+      }
+
+      if (flags & kDistanceResidual) {
+         WriteResidual(m_bytes, first ? quantized.m_distance : distance);
+      }
+
+      PushHistory(m_history, quantized, first);
+      if (absolute) {
+         for (int i = 0; i < 3; ++i) {
+            m_history[1].m_rotation[i] = quantized.m_rotation[i];
+         }
+      }
+      ++m_frameCount;
+
+      // Measure what the decoder will reconstruct.
+      QuantizedChunk chunk;
+      Store(chunk, 0, quantized);
+      CameraState decoded;
+      Dequantize(chunk, 1, m_rotationBits, m_lookAtStep, m_logDistanceStep, &decoded);
+
+      // The angle from the chord between the unit quaternions, acos of their dot product has
+      // no precision left at these angles.
+      const quat& q = state.m_rotation;
+      const quat& d = decoded.m_rotation;
+      const float inv = 1.0f / sqrtf(q.x * q.x + q.y * q.y + q.z * q.z + q.w * q.w);
+      const float sign = (q.x * d.x + q.y * d.y + q.z * d.z + q.w * d.w) < 0.0f ? -inv : inv;
+      const float dx = q.x * sign - d.x, dy = q.y * sign - d.y, dz = q.z * sign - d.z, dw = q.w * sign - d.w;
+      const float chord = sqrtf(dx * dx + dy * dy + dz * dz + dw * dw) * 0.5f;
+      const float angle = 4.0f * asinf(chord < 1.0f ? chord : 1.0f);
+      const float lookAtError = fmaxf(fabsf(decoded.m_lookAt.x - state.m_lookAt.x), fmaxf(fabsf(decoded.m_lookAt.y - state.m_lookAt.y), fabsf(decoded.m_lookAt.z - state.m_lookAt.z)));
+      const float distanceError = fabsf(decoded.m_distance - state.m_distance) / state.m_distance;
+
+      m_error.m_rotationInRadians = fmaxf(m_error.m_rotationInRadians, angle);
+      m_error.m_lookAt = fmaxf(m_error.m_lookAt, lookAtError);
+      m_error.m_distance = fmaxf(m_error.m_distance, distanceError);
+   }
+
+   bool PathDecoder::Open(const uint8_t* bytes, size_t size) {
+      if (size < kPathHeaderSize || memcmp(bytes, kPathMagic, 4) != 0 || bytes[4] != kPathVersion || bytes[5] < 2 || bytes[5] > 16) {
+         return false;
+      }
+
+      m_rotationBits = bytes[5];
+      memcpy(&m_lookAtStep, bytes + 6, 4);
+      memcpy(&m_logDistanceStep, bytes + 10, 4);
+
+      m_data = bytes + kPathHeaderSize;
+      m_end = bytes + size;
+      m_frameCount = 0;
+      return true;
+   }
+
+   size_t PathDecoder::Decode(CameraState* outStates, size_t maxCount) {
+      QuantizedChunk chunk;
+      size_t decoded = 0;
+
+      while (decoded < maxCount && m_data < m_end) {
+         size_t count = 0;
+
+         while (count < kChunkSize && decoded + count < maxCount && m_data < m_end) {
+            const uint8_t* data = m_data;
+            const uint8_t flags = *data++;
+            const bool first = (m_frameCount == 0);
+            const QuantizedState& previous = m_history[0];
+            const QuantizedState& beforePrevious = m_history[1];
+
+            QuantizedState state = previous;
+            bool ok = true;
+
+            if (flags & kRotationAbsolute) {
+               state.m_largestComponent = (flags >> kLargestComponentShift) & 3;
+               for (int i = 0; i < 3 && ok; ++i) {
+                  uint64_t value;
+                  ok = ReadVarint(data, m_end, value);
+                  state.m_rotation[i] = int32_t(value);
+               }
+            } else {
+               for (int i = 0; i < 3; ++i) {
+                  state.m_rotation[i] = int32_t(Predict(previous.m_rotation[i], beforePrevious.m_rotation[i]));
+               }
+               for (int i = 0; i < 3 && ok && (flags & kRotationResidual); ++i) {
+                  ok = ReadResidual(data, m_end, previous.m_rotation[i], beforePrevious.m_rotation[i], state.m_rotation[i]);
+               }
+            }
+
+            for (int i = 0; i < 3 && ok; ++i) {
+               if (flags & kLookAtResidual) {
+                  ok = ReadResidual(data, m_end, first ? 0 : previous.m_lookAt[i], first ? 0 : beforePrevious.m_lookAt[i], state.m_lookAt[i]);
+               } else {
+                  state.m_lookAt[i] = int32_t(Predict(previous.m_lookAt[i], beforePrevious.m_lookAt[i]));
+               }
+            }
+
+            if (ok && (flags & kDistanceResidual)) {
+               ok = ReadResidual(data, m_end, first ? 0 : previous.m_distance, first ? 0 : beforePrevious.m_distance, state.m_distance);
+            } else if (ok) {
+               state.m_distance = int32_t(Predict(previous.m_distance, beforePrevious.m_distance));
+            }
+
+            // A frame cut off at the end of the stream is dropped.
+            if (!ok) {
+               m_data = m_end;
+               break;
+            }
+            m_data = data;
+
+            PushHistory(m_history, state, first);
+            if (flags & kRotationAbsolute) {
+               for (int i = 0; i < 3; ++i) {
+                  m_history[1].m_rotation[i] = state.m_rotation[i];
+               }
+            }
+            ++m_frameCount;
+
+            Store(chunk, count++, state);
+         }
+
+         Dequantize(chunk, count, m_rotationBits, m_lookAtStep, m_logDistanceStep, outStates + decoded);
+         decoded += count;
+      }
+
+      return decoded;
+   }
+
+}
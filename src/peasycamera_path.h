@@ -0,0 +1,75 @@
+#pragma once
+
+#include "peasycamera.h"
+
+namespace peasycamera {
+
+   // Error bounds of a compressed path. The rotation is stored as the three smallest quaternion
+   // components with m_rotationBits bits each (at most 16), the look-at point on a grid of
+   // 2 * m_lookAtPrecision world units and the distance on a log grid with relative error
+   // m_distancePrecision. Decoded values are floats, so large coordinates add their own rounding.
+   struct PathCodecSettings {
+      uint32_t m_rotationBits = 15;
+      float m_lookAtPrecision = 0.0005f;
+      float m_distancePrecision = 0.0001f;
+   };
+
+   // Largest reconstruction error seen by an encoder. Rotation is the angle between the original
+   // and decoded orientation, look-at the largest per-component difference and distance the
+   // largest relative difference.
+   struct PathError {
+      float m_rotationInRadians = 0.0f;
+      float m_lookAt = 0.0f;
+      float m_distance = 0.0f;
+   };
+
+   struct QuantizedState {
+      int32_t m_rotation[3];
+      int32_t m_largestComponent;
+      int32_t m_lookAt[3];
+      int32_t m_distance;
+   };
+
+   // Encodes CameraStates into a byte stream. Every frame is a flags byte followed by zigzag
+   // varints of the quantized values minus their prediction from the two previous frames; a
+   // channel whose prediction is exact is left out. A camera at rest or in steady motion costs
+   // one byte per frame.
+   struct PathEncoder {
+      uint32_t m_rotationBits;
+      float m_lookAtStep;
+      float m_logDistanceStep;
+
+      std::vector<uint8_t> m_bytes;
+      QuantizedState m_history[2] = { };
+      uint64_t m_frameCount = 0;
+      PathError m_error;
+
+      explicit PathEncoder(const PathCodecSettings& settings = { });
+
+      void Add(const CameraState& state);
+
+      float GetBytesPerFrame() const { return m_frameCount > 0 ? float(m_bytes.size()) / float(m_frameCount) : 0.0f; }
+   };
+
+   // Streaming decoder for a PathEncoder byte stream. Frames are parsed into small
+   // structure-of-arrays chunks and reconstructed by a branch-free loop over each chunk.
+   struct PathDecoder {
+      static constexpr size_t kChunkSize = 64;
+
+      uint32_t m_rotationBits = 0;
+      float m_lookAtStep = 0.0f;
+      float m_logDistanceStep = 0.0f;
+
+      const uint8_t* m_data = nullptr;
+      const uint8_t* m_end = nullptr;
+      QuantizedState m_history[2] = { };
+      uint64_t m_frameCount = 0;
+
+      // False if bytes does not start with a path header.
+      bool Open(const uint8_t* bytes, size_t size);
+
+      // Decodes up to maxCount frames into outStates, returns how many were decoded.
+      size_t Decode(CameraState* outStates, size_t maxCount);
+   };
+
+}
@@ -0,0 +1,50 @@
+#include "peasycamera_publisher.h"
+
+namespace peasycamera {
+
+   void CameraPublisher::Publish(Camera& camera) {
+      const float* viewMatrix = camera.GetViewMatrix();
+      Publish(camera.GetRenderState(), viewMatrix, camera.GetEpoch());
+   }
+
+   void CameraPublisher::Publish(const CameraState& state, const float* viewMatrix, uint64_t epoch) {
+      Snapshot& snapshot = m_buffers[m_writeIndex];
+      for (int i = 0; i < 16; ++i) {
+         snapshot.m_viewMatrix[i] = viewMatrix[i];
+      }
+      snapshot.m_state = state;
+      snapshot.m_epoch = epoch;
+      snapshot.m_sequence = ++m_sequence;
+
+      // Release the snapshot, and acquire the buffer the reader last gave back.
+      m_writeIndex = m_middle.exchange(m_writeIndex | kFreshBit, std::memory_order_acq_rel) & kIndexMask;
+   }
+
+   const CameraPublisher::Snapshot& CameraPublisher::Acquire() {
+      if (m_middle.load(std::memory_order_relaxed) & kFreshBit) {
+         m_readIndex = m_middle.exchange(m_readIndex, std::memory_order_acq_rel) & kIndexMask;
+      }
+      return m_buffers[m_readIndex];
+   }
+
+   bool CameraPublisher::LatchViewMatrix(float* outViewMatrix) {
+      const Snapshot& snapshot = Acquire();
+      for (int i = 0; i < 16; ++i) {
+         outViewMatrix[i] = snapshot.m_viewMatrix[i];
+      }
+
+      const bool newer = snapshot.m_sequence != m_latchedSequence;
+      m_latchedSequence = snapshot.m_sequence;
+      return newer;
+   }
+
+   bool CameraPublisher::LatchState(CameraState* outState) {
+      const Snapshot& snapshot = Acquire();
+      *outState = snapshot.m_state;
+
+      const bool newer = snapshot.m_sequence != m_latchedSequence;
+      m_latchedSequence = snapshot.m_sequence;
+      return newer;
+   }
+
+}
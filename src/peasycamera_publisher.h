@@ -0,0 +1,56 @@
+#pragma once
+
+#include "peasycamera.h"
+
+#include <atomic>
+
+namespace peasycamera {
+
+   // Hands camera poses from the update thread to the render thread without locks. Triple
+   // buffered: the writer fills its own buffer and swaps it into the shared middle slot, the
+   // reader swaps its buffer for the middle one when that holds something newer. Neither side
+   // ever waits and the reader always sees a complete snapshot. One writer and one reader only.
+   struct CameraPublisher {
+      // Before the first Publish every snapshot holds the identity pose: a camera at the origin
+      // with the identity view matrix.
+      struct alignas(kCacheLineSize) Snapshot {
+         float m_viewMatrix[16] = {1.0f, 0.0f, 0.0f, 0.0f, 0.0f, 1.0f, 0.0f, 0.0f, 0.0f, 0.0f, 1.0f, 0.0f, 0.0f, 0.0f, 0.0f, 1.0f};
+         CameraState m_state = {kIdentityRotation, {0.0f, 0.0f, 0.0f}, 0.0f};
+
+         // Camera::GetEpoch of the published state, and the number of Publish calls so far.
+         uint64_t m_epoch = 0;
+         uint64_t m_sequence = 0;
+      };
+
+      static constexpr uint32_t kIndexMask = 3;
+      static constexpr uint32_t kFreshBit = 4;
+
+      Snapshot m_buffers[3];
+
+      // Index of the middle buffer, with kFreshBit set while the reader has not taken it.
+      alignas(kCacheLineSize) std::atomic<uint32_t> m_middle {1};
+
+      // Owned by the writer.
+      alignas(kCacheLineSize) uint32_t m_writeIndex = 0;
+      uint64_t m_sequence = 0;
+
+      // Owned by the reader.
+      alignas(kCacheLineSize) uint32_t m_readIndex = 2;
+      uint64_t m_latchedSequence = 0;
+
+      // Update thread. Publish(camera) publishes Camera::GetRenderState() and its view matrix.
+      void Publish(Camera& camera);
+      void Publish(const CameraState& state, const float* viewMatrix, uint64_t epoch);
+
+      // Render thread. The newest published snapshot, valid until the next Acquire or Latch*.
+      const Snapshot& Acquire();
+
+      // Late latch for the render thread: call right before submit and write straight into the
+      // mapped constant buffer the recorded commands read from, so the frame uses the pose
+      // published while it was being built. Returns true if the pose is newer than the previous
+      // latch; before the first Publish it returns false and writes the identity pose.
+      bool LatchViewMatrix(float* outViewMatrix);
+      bool LatchState(CameraState* outState);
+   };
+
+}
@@ -0,0 +1,304 @@
+#include "peasycamera_recorder.h"
+#include <string.h>
+
+#if defined(_WIN32)
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace peasycamera {
+   namespace {
+      const char kSessionMagic[4] = {'P', 'C', 'S', 'R'};
+
+      constexpr uint32_t kLeftMouseButton = 1 << 0;
+      constexpr uint32_t kMiddleMouseButton = 1 << 1;
+      constexpr uint32_t kRightMouseButton = 1 << 2;
+      constexpr uint32_t kShiftKey = 1 << 3;
+
+      size_t BlockSize(const SessionHeader& header) {
+         return header.m_keyframeSize + size_t(header.m_keyframeInterval) * header.m_inputSize;
+      }
+
+      void InputHook(void* context, const Camera& camera, const Input& input) {
+         static_cast<SessionRecorder*>(context)->Record(camera, input);
+      }
+   }
+
+   SessionKeyframe MakeKeyframe(const Camera& camera) {
+      SessionKeyframe keyframe = { };
+      keyframe.m_state = camera.m_state;
+      const DampedAction* actions[6] = {&camera.m_panX, &camera.m_panY, &camera.m_zoom, &camera.m_rotateX, &camera.m_rotateY, &camera.m_rotateZ};
+      for (int i = 0; i < 6; ++i) {
+         keyframe.m_velocities[i] = actions[i]->m_velocity;
+         keyframe.m_springOffsets[i] = actions[i]->m_springOffset;
+         keyframe.m_springRates[i] = actions[i]->m_springRate;
+         keyframe.m_settleTimesLeft[i] = actions[i]->m_settleTimeLeft;
+      }
+      keyframe.m_distanceInterpolator = camera.m_distanceInterpolator;
+      keyframe.m_lookAtInterpolator = camera.m_lookAtInterpolator;
+      keyframe.m_rotationInterpolator = camera.m_rotationInterpolator;
+      keyframe.m_dragConstraint = uint32_t(camera.m_dragConstraint);
+      keyframe.m_asleep = camera.m_asleep ? 1 : 0;
+      keyframe.m_previousState = camera.m_previousState;
+      keyframe.m_fixedTimeLeft = camera.m_fixedTimeLeft;
+      keyframe.m_previousStateValid = camera.m_previousStateEpoch == camera.m_epoch ? 1 : 0;
+      return keyframe;
+   }
+
+   void ApplyKeyframe(const SessionKeyframe& keyframe, Camera& camera) {
+      camera.m_state = keyframe.m_state;
+      DampedAction* actions[6] = {&camera.m_panX, &camera.m_panY, &camera.m_zoom, &camera.m_rotateX, &camera.m_rotateY, &camera.m_rotateZ};
+      for (int i = 0; i < 6; ++i) {
+         actions[i]->m_velocity = keyframe.m_velocities[i];
+         actions[i]->m_springOffset = keyframe.m_springOffsets[i];
+         actions[i]->m_springRate = keyframe.m_springRates[i];
+         actions[i]->m_settleTimeLeft = keyframe.m_settleTimesLeft[i];
+      }
+      camera.m_distanceInterpolator = keyframe.m_distanceInterpolator;
+      camera.m_lookAtInterpolator = keyframe.m_lookAtInterpolator;
+      camera.m_rotationInterpolator = keyframe.m_rotationInterpolator;
+      camera.m_dragConstraint = Constraint(keyframe.m_dragConstraint);
+      camera.m_asleep = keyframe.m_asleep != 0;
+      camera.m_previousState = keyframe.m_previousState;
+      camera.m_fixedTimeLeft = keyframe.m_fixedTimeLeft;
+      ++camera.m_epoch;
+      camera.m_previousStateEpoch = keyframe.m_previousStateValid != 0 ? camera.m_epoch : camera.m_epoch - 1;
+   }
+
+   SessionRecorder::~SessionRecorder() {
+      Close();
+   }
+
+   bool SessionRecorder::Open(const char* path, uint32_t keyframeInterval) {
+      Close();
+
+      m_file = fopen(path, "wb");
+      if (!m_file) {
+         return false;
+      }
+      setvbuf(m_file, nullptr, _IOFBF, 1 << 16);
+
+      m_keyframeInterval = keyframeInterval > 0 ? keyframeInterval : 1;
+      m_frameCount = 0;
+      m_writeFailed = false;
+
+      SessionHeader header = { };
+      memcpy(header.m_magic, kSessionMagic, sizeof(kSessionMagic));
+      header.m_version = kSessionVersion;
+      header.m_keyframeInterval = m_keyframeInterval;
+      header.m_keyframeSize = uint32_t(sizeof(SessionKeyframe));
+      header.m_inputSize = uint32_t(sizeof(SessionInput));
+
+      if (fwrite(&header, sizeof(header), 1, m_file) != 1) {
+         Close();
+         return false;
+      }
+      return true;
+   }
+
+   void SessionRecorder::Close() {
+      if (m_file) {
+         m_writeFailed = fclose(m_file) != 0 || m_writeFailed;
+         m_file = nullptr;
+      }
+   }
+
+   bool SessionRecorder::Record(const Camera& camera, const Input& input) {
+      if (!m_file) {
+         return false;
+      }
+
+      if (m_frameCount % m_keyframeInterval == 0) {
+         const SessionKeyframe keyframe = MakeKeyframe(camera);
+         if (fwrite(&keyframe, sizeof(keyframe), 1, m_file) != 1) {
+            m_writeFailed = true;
+            Close();
+            return false;
+         }
+      }
+
+      SessionInput record = { };
+      for (int i = 0; i < 4; ++i) {
+         record.m_viewport[i] = input.viewport[i];
+      }
+      record.m_mouseX = input.mouseX;
+      record.m_mouseY = input.mouseY;
+      record.m_mouseDX = input.mouseDX;
+      record.m_mouseDY = input.mouseDY;
+      record.m_mouseWheelDelta = input.mouseWheelDelta;
+      record.m_deltaTimeInSeconds = input.deltaTimeInSeconds;
+      record.m_buttons = (input.leftMouseButtonDown ? kLeftMouseButton : 0u) | (input.middleMouseButtonDown ? kMiddleMouseButton : 0u) |
+                         (input.rightMouseButtonDown ? kRightMouseButton : 0u) | (input.shiftKeyDown ? kShiftKey : 0u);
+
+      if (fwrite(&record, sizeof(record), 1, m_file) != 1) {
+         m_writeFailed = true;
+         Close();
+         return false;
+      }
+      ++m_frameCount;
+      return true;
+   }
+
+   void SessionRecorder::Attach(Camera& camera) {
+      camera.m_inputHook = InputHook;
+      camera.m_inputHookContext = this;
+   }
+
+   void SessionRecorder::Detach(Camera& camera) {
+      camera.m_inputHook = nullptr;
+      camera.m_inputHookContext = nullptr;
+   }
+
+   SessionReplay::~SessionReplay() {
+      Close();
+   }
+
+   bool SessionReplay::Open(const char* path) {
+      Close();
+
+#if defined(_WIN32)
+      HANDLE file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+      if (file == INVALID_HANDLE_VALUE) {
+         return false;
+      }
+      m_fileHandle = file;
+
+      LARGE_INTEGER size;
+      if (!GetFileSizeEx(file, &size) || size.QuadPart < LONGLONG(sizeof(SessionHeader))) {
+         Close();
+         return false;
+      }
+
+      m_mappingHandle = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+      if (!m_mappingHandle) {
+         Close();
+         return false;
+      }
+
+      m_data = static_cast<const uint8_t*>(MapViewOfFile(m_mappingHandle, FILE_MAP_READ, 0, 0, 0));
+      m_size = size_t(size.QuadPart);
+#else
+      const int file = open(path, O_RDONLY);
+      if (file < 0) {
+         return false;
+      }
+
+      struct stat info;
+      if (fstat(file, &info) != 0 || size_t(info.st_size) < sizeof(SessionHeader)) {
+         close(file);
+         return false;
+      }
+
+      void* data = mmap(nullptr, size_t(info.st_size), PROT_READ, MAP_PRIVATE, file, 0);
+      close(file);
+
+      m_data = data != MAP_FAILED ? static_cast<const uint8_t*>(data) : nullptr;
+      m_size = size_t(info.st_size);
+#endif
+
+      if (!m_data) {
+         Close();
+         return false;
+      }
+
+      memcpy(&m_header, m_data, sizeof(m_header));
+      if (memcmp(m_header.m_magic, kSessionMagic, sizeof(kSessionMagic)) != 0 || m_header.m_version != kSessionVersion || m_header.m_keyframeInterval == 0 ||
+          m_header.m_keyframeSize != sizeof(SessionKeyframe) || m_header.m_inputSize != sizeof(SessionInput)) {
+         Close();
+         return false;
+      }
+
+      // A session cut off mid-record (e.g. by a crash) ends at the last complete input.
+      const size_t blockSize = BlockSize(m_header);
+      const size_t payload = m_size - sizeof(SessionHeader);
+      const size_t tail = payload % blockSize;
+      m_frameCount = uint64_t(payload / blockSize) * m_header.m_keyframeInterval;
+      if (tail > m_header.m_keyframeSize) {
+         m_frameCount += (tail - m_header.m_keyframeSize) / m_header.m_inputSize;
+      }
+      return true;
+   }
+
+   void SessionReplay::Close() {
+#if defined(_WIN32)
+      if (m_data) {
+         UnmapViewOfFile(m_data);
+      }
+      if (m_mappingHandle) {
+         CloseHandle(m_mappingHandle);
+      }
+      if (m_fileHandle) {
+         CloseHandle(m_fileHandle);
+      }
+      m_mappingHandle = nullptr;
+      m_fileHandle = nullptr;
+#else
+      if (m_data) {
+         munmap(const_cast<uint8_t*>(m_data), m_size);
+      }
+#endif
+
+      m_data = nullptr;
+      m_size = 0;
+      m_frameCount = 0;
+   }
+
+   Input SessionReplay::GetInput(uint64_t frame) const {
+      const uint64_t block = frame / m_header.m_keyframeInterval;
+      const uint64_t index = frame % m_header.m_keyframeInterval;
+      const size_t offset = sizeof(SessionHeader) + size_t(block) * BlockSize(m_header) + m_header.m_keyframeSize + size_t(index) * m_header.m_inputSize;
+
+      SessionInput record;
+      memcpy(&record, m_data + offset, sizeof(record));
+
+      Input input;
+      for (int i = 0; i < 4; ++i) {
+         input.viewport[i] = record.m_viewport[i];
+      }
+      input.mouseX = record.m_mouseX;
+      input.mouseY = record.m_mouseY;
+      input.mouseDX = record.m_mouseDX;
+      input.mouseDY = record.m_mouseDY;
+      input.mouseWheelDelta = record.m_mouseWheelDelta;
+      input.deltaTimeInSeconds = record.m_deltaTimeInSeconds;
+      input.leftMouseButtonDown = (record.m_buttons & kLeftMouseButton) != 0;
+      input.middleMouseButtonDown = (record.m_buttons & kMiddleMouseButton) != 0;
+      input.rightMouseButtonDown = (record.m_buttons & kRightMouseButton) != 0;
+      input.shiftKeyDown = (record.m_buttons & kShiftKey) != 0;
+      return input;
+   }
+
+   SessionKeyframe SessionReplay::GetKeyframe(uint64_t frame) const {
+      const uint64_t block = frame / m_header.m_keyframeInterval;
+
+      SessionKeyframe keyframe;
+      memcpy(&keyframe, m_data + sizeof(SessionHeader) + size_t(block) * BlockSize(m_header), sizeof(keyframe));
+      return keyframe;
+   }
+
+   void SessionReplay::Seek(Camera& camera, uint64_t frame) const {
+      // A session without inputs has no keyframe either.
+      if (m_frameCount == 0) {
+         return;
+      }
+
+      // The keyframe of a block is only written along with its first input.
+      frame = frame < m_frameCount ? frame : m_frameCount;
+      const uint64_t keyframe = (frame == m_frameCount && frame > 0 ? frame - 1 : frame) / m_header.m_keyframeInterval * m_header.m_keyframeInterval;
+      ApplyKeyframe(GetKeyframe(keyframe), camera);
+      Replay(camera, keyframe, frame);
+   }
+
+   void SessionReplay::Replay(Camera& camera, uint64_t begin, uint64_t end) const {
+      end = end < m_frameCount ? end : m_frameCount;
+      for (uint64_t frame = begin; frame < end; ++frame) {
+         camera.Update(GetInput(frame));
+      }
+   }
+
+}
@@ -0,0 +1,127 @@
+#pragma once
+
+#include "peasycamera.h"
+
+#include <stdio.h>
+
+namespace peasycamera {
+
+   // Session file layout: a SessionHeader, then blocks of one SessionKeyframe followed by
+   // m_keyframeInterval SessionInputs. Every record has a fixed size, so frame n is found with
+   // arithmetic alone; the last block may be partial. All values are stored in native byte order.
+   constexpr uint32_t kSessionVersion = 3;
+
+   struct SessionHeader {
+      char m_magic[4];
+      uint32_t m_version;
+      uint32_t m_keyframeInterval;
+      uint32_t m_keyframeSize;
+      uint32_t m_inputSize;
+      uint32_t m_reserved[3];
+   };
+
+   // Everything Update changes, so a replay can start at any keyframe and still match the
+   // recording bit for bit. The configuration (friction, damping mode, settle time, fixed time
+   // step, settle threshold, distance limits, rotation mode) is not recorded: replay into a
+   // camera set up the same way as the recorded one.
+   struct SessionKeyframe {
+      CameraState m_state;
+      CameraState m_previousState;
+      float m_velocities[6];
+      float m_springOffsets[6];
+      float m_springRates[6];
+      float m_settleTimesLeft[6];
+      Interpolator<float> m_distanceInterpolator;
+      Interpolator<vec3> m_lookAtInterpolator;
+      Interpolator<quat> m_rotationInterpolator;
+      uint32_t m_dragConstraint;
+      uint32_t m_asleep;
+      float m_fixedTimeLeft;
+      uint32_t m_previousStateValid;
+   };
+
+   struct SessionInput {
+      int32_t m_viewport[4];
+      int32_t m_mouseX;
+      int32_t m_mouseY;
+      int32_t m_mouseDX;
+      int32_t m_mouseDY;
+      int32_t m_mouseWheelDelta;
+      float m_deltaTimeInSeconds;
+      uint32_t m_buttons;
+      uint32_t m_reserved;
+   };
+
+   SessionKeyframe MakeKeyframe(const Camera& camera);
+   void ApplyKeyframe(const SessionKeyframe& keyframe, Camera& camera);
+
+   // Appends every Input given to the attached camera's Update to a session file through a
+   // large stdio buffer, with a keyframe every keyframeInterval frames. Only Update(const Input&)
+   // is recorded. The InputEvent overload of Update, which peasycamera::Update feeds from an
+   // InputEventQueue, is not: sessions hold one fixed-size Input per frame. Those updates and
+   // Set*, Rotate*, Pan and Reset calls made while recording show up at the next keyframe at the
+   // earliest, so a replay that crosses one diverges.
+   struct SessionRecorder {
+      FILE* m_file = nullptr;
+      uint32_t m_keyframeInterval = 0;
+      uint64_t m_frameCount = 0;
+
+      // Set when a write or the final flush fails, until the next Open. A failed write closes the
+      // file, which then ends at the last complete input like a session cut off by a crash.
+      bool m_writeFailed = false;
+
+      SessionRecorder() = default;
+      ~SessionRecorder();
+
+      SessionRecorder(const SessionRecorder&) = delete;
+      SessionRecorder& operator =(const SessionRecorder&) = delete;
+
+      bool Open(const char* path, uint32_t keyframeInterval = 256);
+      void Close();
+
+      // Records input as the next frame of camera. Attach does this from inside Camera::Update.
+      // False if no file is open or the write failed, see m_writeFailed.
+      bool Record(const Camera& camera, const Input& input);
+
+      void Attach(Camera& camera);
+      static void Detach(Camera& camera);
+   };
+
+   // Read-only memory mapping of a session file. Frames are decoded in place, nothing is parsed
+   // up front.
+   struct SessionReplay {
+      const uint8_t* m_data = nullptr;
+      size_t m_size = 0;
+      SessionHeader m_header = { };
+      uint64_t m_frameCount = 0;
+
+#if defined(_WIN32)
+      void* m_fileHandle = nullptr;
+      void* m_mappingHandle = nullptr;
+#endif
+
+      SessionReplay() = default;
+      ~SessionReplay();
+
+      SessionReplay(const SessionReplay&) = delete;
+      SessionReplay& operator =(const SessionReplay&) = delete;
+
+      bool Open(const char* path);
+      void Close();
+
+      uint64_t GetFrameCount() const { return m_frameCount; }
+      Input GetInput(uint64_t frame) const;
+
+      // The keyframe stored before frame, rounded down to the keyframe interval. frame has to be
+      // below GetFrameCount().
+      SessionKeyframe GetKeyframe(uint64_t frame) const;
+
+      // Puts camera into the recorded state before frame: applies the nearest keyframe and
+      // replays the inputs between it and frame. Leaves camera alone if the session has no frames.
+      void Seek(Camera& camera, uint64_t frame) const;
+
+      // Calls camera.Update with the recorded inputs of [begin, end).
+      void Replay(Camera& camera, uint64_t begin, uint64_t end) const;
+   };
+
+}
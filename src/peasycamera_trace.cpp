@@ -0,0 +1,163 @@
+#include "peasycamera_trace.h"
+#include <math.h>
+
+namespace peasycamera {
+   namespace {
+      constexpr float kPi = 3.14159265f;
+
+      uint64_t SplitMix64(uint64_t value) {
+         value += 0x9e3779b97f4a7c15ull;
+         value = (value ^ (value >> 30)) * 0xbf58476d1ce4e5b9ull;
+         value = (value ^ (value >> 27)) * 0x94d049bb133111ebull;
+         return value ^ (value >> 31);
+      }
+
+      bool Dragging(Gesture gesture) {
+         return gesture == Gesture::OrbitDrag || gesture == Gesture::ConstrainedDrag || gesture == Gesture::Pan || gesture == Gesture::Zoom || gesture == Gesture::ViewportExit;
+      }
+   }
+
+   TraceGenerator::TraceGenerator(const TraceSettings& settings, uint64_t stream) : m_settings(&settings) {
+      m_random = SplitMix64(settings.m_seed ^ SplitMix64(stream));
+
+      const int* viewport = settings.m_viewport;
+      m_mouseX = float(viewport[0]) + float(viewport[2]) * (0.25f + 0.5f * NextUniform());
+      m_mouseY = float(viewport[1]) + float(viewport[3]) * (0.25f + 0.5f * NextUniform());
+
+      StartGesture();
+   }
+
+   // PCG32 (XSH RR).
+   uint32_t TraceGenerator::NextRandom() {
+      const uint64_t state = m_random;
+      m_random = state * 6364136223846793005ull + 1442695040888963407ull;
+      const uint32_t xorShifted = uint32_t(((state >> 18) ^ state) >> 27);
+      const uint32_t rotation = uint32_t(state >> 59);
+      return (xorShifted >> rotation) | (xorShifted << ((32 - rotation) & 31));
+   }
+
+   float TraceGenerator::NextUniform() {
+      return float(NextRandom() >> 8) * (1.0f / 16777216.0f);
+   }
+
+   void TraceGenerator::StartGesture() {
+      const TraceSettings& settings = *m_settings;
+
+      float total = 0.0f;
+      for (float weight : settings.m_weights) {
+         total += weight;
+      }
+
+      float pick = NextUniform() * total;
+      int gesture = 0;
+      while (gesture + 1 < int(Gesture::Count) && pick >= settings.m_weights[gesture]) {
+         pick -= settings.m_weights[gesture];
+         ++gesture;
+      }
+      m_gesture = Gesture(gesture);
+
+      m_gestureTime = 0.0f;
+      m_gestureDuration = 0.05f - settings.m_meanDurations[gesture] * logf(1.0f - NextUniform());
+      m_peakSpeed = settings.m_minDragSpeed + (settings.m_maxDragSpeed - settings.m_minDragSpeed) * NextUniform();
+      m_direction = 2.0f * kPi * NextUniform();
+      m_turnRate = (NextUniform() - 0.5f) * 2.0f;
+      m_wheelSign = NextUniform() < 0.5f ? -1 : 1;
+
+      if (m_gesture == Gesture::ConstrainedDrag) {
+         // Close to one axis so the drag constraint locks on.
+         const float axis = float(NextRandom() & 3) * 0.5f * kPi;
+         m_direction = axis + (NextUniform() - 0.5f) * 0.3f;
+         m_turnRate = 0.0f;
+      } else if (m_gesture == Gesture::Zoom) {
+         m_direction = (NextUniform() < 0.5f ? 0.5f : 1.5f) * kPi + (NextUniform() - 0.5f) * 0.4f;
+         m_turnRate = 0.0f;
+      } else if (m_gesture == Gesture::ViewportExit) {
+         // Head for the nearest viewport edge fast enough to leave before the gesture ends.
+         const int* viewport = settings.m_viewport;
+         const float toLeft = m_mouseX - float(viewport[0]);
+         const float toRight = float(viewport[0] + viewport[2]) - m_mouseX;
+         const float toTop = m_mouseY - float(viewport[1]);
+         const float toBottom = float(viewport[1] + viewport[3]) - m_mouseY;
+         const float nearest = fminf(fminf(toLeft, toRight), fminf(toTop, toBottom));
+
+         m_direction = nearest == toLeft ? kPi : (nearest == toRight ? 0.0f : (nearest == toTop ? 1.5f * kPi : 0.5f * kPi));
+         m_turnRate = 0.0f;
+         m_peakSpeed = fmaxf(m_peakSpeed, 4.0f * nearest / m_gestureDuration);
+      }
+   }
+
+   Input TraceGenerator::Next() {
+      const TraceSettings& settings = *m_settings;
+      const int* viewport = settings.m_viewport;
+
+      Input input = { };
+      for (int i = 0; i < 4; ++i) {
+         input.viewport[i] = viewport[i];
+      }
+
+      const float jitter = settings.m_frameTimeJitter * (2.0f * NextUniform() - 1.0f);
+      const float dt = (1.0f + jitter) / settings.m_frameRate;
+      input.deltaTimeInSeconds = dt;
+
+      // Bell-shaped speed over the gesture, slow hover while idle.
+      const float t = fminf(m_gestureTime / m_gestureDuration, 1.0f);
+      float speed = Dragging(m_gesture) ? m_peakSpeed * sinf(kPi * t) * sinf(kPi * t) : 0.0f;
+      if (m_gesture == Gesture::Idle) {
+         speed = NextUniform() < 0.02f ? 100.0f : 0.0f;
+      }
+
+      m_direction += m_turnRate * dt;
+      m_subPixelX += speed * cosf(m_direction) * dt;
+      m_subPixelY += speed * sinf(m_direction) * dt;
+
+      const float dx = truncf(m_subPixelX);
+      const float dy = truncf(m_subPixelY);
+      m_subPixelX -= dx;
+      m_subPixelY -= dy;
+
+      // Outside of a viewport exit the cursor slides along the viewport edge.
+      float x = m_mouseX + dx;
+      float y = m_mouseY + dy;
+      if (m_gesture != Gesture::ViewportExit) {
+         x = fminf(fmaxf(x, float(viewport[0])), float(viewport[0] + viewport[2]));
+         y = fminf(fmaxf(y, float(viewport[1])), float(viewport[1] + viewport[3]));
+      }
+
+      // Deltas between the rounded positions, so they always add up to the reported motion; the
+      // clamp to the viewport edge can leave a fraction that truncating x - m_mouseX would drop.
+      input.mouseDX = int(lroundf(x)) - int(lroundf(m_mouseX));
+      input.mouseDY = int(lroundf(y)) - int(lroundf(m_mouseY));
+      m_mouseX = x;
+      m_mouseY = y;
+      input.mouseX = int(lroundf(m_mouseX));
+      input.mouseY = int(lroundf(m_mouseY));
+
+      input.leftMouseButtonDown = (m_gesture == Gesture::OrbitDrag || m_gesture == Gesture::ConstrainedDrag || m_gesture == Gesture::ViewportExit);
+      input.middleMouseButtonDown = (m_gesture == Gesture::Pan);
+      input.rightMouseButtonDown = (m_gesture == Gesture::Zoom);
+      input.shiftKeyDown = (m_gesture == Gesture::ConstrainedDrag);
+
+      if (m_gesture == Gesture::WheelBurst && NextUniform() < 0.3f * 60.0f * dt) {
+         input.mouseWheelDelta = m_wheelSign;
+      }
+
+      m_gestureTime += dt;
+      if (m_gestureTime >= m_gestureDuration) {
+         // Back over the viewport after leaving it.
+         if (m_gesture == Gesture::ViewportExit) {
+            m_mouseX = float(viewport[0]) + float(viewport[2]) * (0.25f + 0.5f * NextUniform());
+            m_mouseY = float(viewport[1]) + float(viewport[3]) * (0.25f + 0.5f * NextUniform());
+         }
+         StartGesture();
+      }
+
+      return input;
+   }
+
+   void TraceGenerator::Drive(Camera& camera, size_t frameCount) {
+      for (size_t i = 0; i < frameCount; ++i) {
+         camera.Update(Next());
+      }
+   }
+
+}
@@ -0,0 +1,62 @@
+#pragma once
+
+#include "peasycamera.h"
+
+namespace peasycamera {
+
+   enum class Gesture : uint8_t { Idle, OrbitDrag, ConstrainedDrag, Pan, Zoom, WheelBurst, ViewportExit, Count };
+
+   struct TraceSettings {
+      uint64_t m_seed = 1;
+      float m_frameRate = 60.0f;
+      // Each frame time is scaled by a uniform factor in [1 - jitter, 1 + jitter].
+      float m_frameTimeJitter = 0.0f;
+      int m_viewport[4] = {0, 0, 1280, 720};
+
+      // Relative frequency and mean length in seconds of each Gesture.
+      float m_weights[size_t(Gesture::Count)] = {0.35f, 0.25f, 0.07f, 0.12f, 0.08f, 0.10f, 0.03f};
+      float m_meanDurations[size_t(Gesture::Count)] = {2.0f, 1.2f, 1.0f, 1.0f, 0.8f, 0.4f, 1.5f};
+
+      // Peak hand speed of drags in pixels per second, drawn per gesture from this range.
+      float m_minDragSpeed = 200.0f;
+      float m_maxDragSpeed = 1500.0f;
+   };
+
+   // Deterministic stream of human-like Inputs: a sequence of gestures with exponentially
+   // distributed lengths. Drags follow a bell-shaped speed profile along a slowly turning
+   // direction and sub-pixel motion is carried over, so the integer deltas add up to the path.
+   // Constrained drags hold shift and move along one axis, viewport exits leave the viewport
+   // with a button held. The state is small enough to keep one generator per simulated user.
+   struct TraceGenerator {
+      const TraceSettings* m_settings;
+      uint64_t m_random;
+
+      float m_mouseX;
+      float m_mouseY;
+      float m_subPixelX = 0.0f;
+      float m_subPixelY = 0.0f;
+      float m_direction = 0.0f;
+      float m_turnRate = 0.0f;
+      float m_peakSpeed = 0.0f;
+
+      float m_gestureTime = 0.0f;
+      float m_gestureDuration = 0.0f;
+      Gesture m_gesture = Gesture::Idle;
+      int8_t m_wheelSign = 1;
+
+      // settings must outlive the generator. stream selects an independent sequence for the same
+      // seed, e.g. the user index.
+      TraceGenerator(const TraceSettings& settings, uint64_t stream = 0);
+
+      Input Next();
+
+      // Updates camera with the next frameCount inputs. A camera with a SessionRecorder attached
+      // records them as it goes.
+      void Drive(Camera& camera, size_t frameCount);
+
+      uint32_t NextRandom();
+      float NextUniform();
+      void StartGesture();
+   };
+
+}